@@ -0,0 +1,143 @@
+/**
+  ******************************************************************************
+  * @file    dma.h
+  * @brief   This file contains all the function prototypes for
+  *          the dma.c file
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2021 STMicroelectronics.
+  * All rights reserved.</center></h2>
+  *
+  * This software component is licensed by ST under BSD 3-Clause license,
+  * the "License"; You may not use this file except in compliance with the
+  * License. You may obtain a copy of the License at:
+  *                        opensource.org/licenses/BSD-3-Clause
+  *
+  ******************************************************************************
+  */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __DMA_H__
+#define __DMA_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+
+/* USER CODE BEGIN Includes */
+
+/* USER CODE END Includes */
+
+/* USER CODE BEGIN Private defines */
+/* DMA1 channel triggered by TIM4 update event, see RM0008 DMA1 request mapping */
+#define SCAN_DMA_Channel DMA1_Channel7
+#define SCAN_DMA_IRQn    DMA1_Channel7_IRQn
+#define SCAN_DMA_IFCR    DMA_IFCR_CGIF7
+
+/* DMA1 channel serving SPI2_TX requests, OLED frame flush */
+#define OLED_DMA_Channel DMA1_Channel5
+#define OLED_DMA_IRQn    DMA1_Channel5_IRQn
+#define OLED_DMA_IFCR    DMA_IFCR_CGIF5
+
+/* DMA1 channel serving USART3_TX requests, serial port output */
+#define UART_TX_DMA_Channel DMA1_Channel2
+#define UART_TX_DMA_IRQn    DMA1_Channel2_IRQn
+#define UART_TX_DMA_IFCR    DMA_IFCR_CGIF2
+/* DMA1 channel serving USART3_RX requests, serial port input */
+#define UART_RX_DMA_Channel DMA1_Channel3
+#define UART_RX_DMA_IRQn    DMA1_Channel3_IRQn
+#define UART_RX_DMA_IFCR    DMA_IFCR_CGIF3
+/* USER CODE END Private defines */
+
+void MX_DMA_Init(void);
+
+/* USER CODE BEGIN Prototypes */
+/**
+ * start peripheral to memory transfer of 'len' segments port samples to 'buf',
+ * one sample per DMA request, transfer complete interrupt at the end
+ */
+static inline void dma_scan_start(uint8_t *buf, uint16_t len) {
+	SCAN_DMA_Channel->CCR = 0;
+	DMA1->IFCR = SCAN_DMA_IFCR;
+	SCAN_DMA_Channel->CPAR = (uint32_t)&SEG_GPIO_Port->IDR;
+	SCAN_DMA_Channel->CMAR = (uint32_t)buf;
+	SCAN_DMA_Channel->CNDTR = len;
+	/* 32 bit peripheral to 8 bit memory keeps the lowest byte: PA0..PA7 segments */
+	SCAN_DMA_Channel->CCR = DMA_CCR_PL_1 | DMA_CCR_PSIZE_1 | DMA_CCR_MINC | DMA_CCR_TCIE | DMA_CCR_EN;
+}
+
+static inline void dma_scan_stop(void) {
+	SCAN_DMA_Channel->CCR = 0;
+	DMA1->IFCR = SCAN_DMA_IFCR;
+}
+
+/**
+ * start memory to SPI transfer
+ * @param len: number of bytes, or half-words if 'half' is set
+ * @param minc: false to send the same byte 'len' times
+ * @param half: true for 16 bit transfers, SPI must use 16 bit data frame
+ */
+static inline void dma_spi_tx_start(SPI_TypeDef *spi, const uint8_t *buf, uint16_t len, bool minc, bool half) {
+	OLED_DMA_Channel->CCR = 0;
+	DMA1->IFCR = OLED_DMA_IFCR;
+	OLED_DMA_Channel->CPAR = (uint32_t)&spi->DR;
+	OLED_DMA_Channel->CMAR = (uint32_t)buf;
+	OLED_DMA_Channel->CNDTR = len;
+	OLED_DMA_Channel->CCR = DMA_CCR_DIR | (minc ? DMA_CCR_MINC : 0) | (half ? DMA_CCR_MSIZE_0 | DMA_CCR_PSIZE_0 : 0)
+						  | DMA_CCR_TCIE | DMA_CCR_EN;
+	spi->CR2 |= SPI_CR2_TXDMAEN;
+}
+
+static inline void dma_spi_tx_stop(SPI_TypeDef *spi) {
+	spi->CR2 &= ~SPI_CR2_TXDMAEN;
+	OLED_DMA_Channel->CCR = 0;
+	DMA1->IFCR = OLED_DMA_IFCR;
+}
+
+/* start memory to USART transfer of 'len' bytes, transfer complete interrupt at the end */
+static inline void dma_uart_tx_start(USART_TypeDef *uart, const uint8_t *buf, uint16_t len) {
+	UART_TX_DMA_Channel->CCR = 0;
+	DMA1->IFCR = UART_TX_DMA_IFCR;
+	UART_TX_DMA_Channel->CPAR = (uint32_t)&uart->DR;
+	UART_TX_DMA_Channel->CMAR = (uint32_t)buf;
+	UART_TX_DMA_Channel->CNDTR = len;
+	UART_TX_DMA_Channel->CCR = DMA_CCR_DIR | DMA_CCR_MINC | DMA_CCR_TCIE | DMA_CCR_EN;
+	uart->CR3 |= USART_CR3_DMAT;
+}
+
+static inline void dma_uart_tx_stop(USART_TypeDef *uart) {
+	uart->CR3 &= ~USART_CR3_DMAT;
+	UART_TX_DMA_Channel->CCR = 0;
+	DMA1->IFCR = UART_TX_DMA_IFCR;
+}
+
+/**
+ * start circular USART to memory transfer to 'buf' of 'len' bytes,
+ * half transfer and transfer complete interrupts
+ */
+static inline void dma_uart_rx_start(USART_TypeDef *uart, uint8_t *buf, uint16_t len) {
+	UART_RX_DMA_Channel->CCR = 0;
+	DMA1->IFCR = UART_RX_DMA_IFCR;
+	UART_RX_DMA_Channel->CPAR = (uint32_t)&uart->DR;
+	UART_RX_DMA_Channel->CMAR = (uint32_t)buf;
+	UART_RX_DMA_Channel->CNDTR = len;
+	UART_RX_DMA_Channel->CCR = DMA_CCR_CIRC | DMA_CCR_MINC | DMA_CCR_HTIE | DMA_CCR_TCIE | DMA_CCR_EN;
+	uart->CR3 |= USART_CR3_DMAR;
+}
+
+/* number of bytes written by the circular transfer since it wrapped around */
+static inline uint16_t dma_uart_rx_pos(uint16_t len) {
+	return len - UART_RX_DMA_Channel->CNDTR;
+}
+/* USER CODE END Prototypes */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __DMA_H__ */
+
+/************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
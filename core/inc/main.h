@@ -22,6 +22,9 @@
 
 #include "target.h"
 #include "lib/ticker.h"
+#include "lib/vfd.h"
+#include "lib/scanq.h"
+#include "lib/renderq.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -34,14 +37,11 @@ void SystemClock_Config(void);
 #define SCAN_GPIO_Port GPIOB
 #define SCAN_EXTI_IRQn EXTI0_IRQn
 
-#define SEG_A   0x01
-#define SEG_B   0x02
-#define SEG_C   0x04
-#define SEG_D   0x08
-#define SEG_E   0x10
-#define SEG_F   0x20
-#define SEG_G   0x40
-#define SEG_DOT 0x80
+/**
+ * 1: timestamp the scan pin edges by TIM3 channel 3 input capture (PB0 is TIM3_CH3),
+ * 0: use EXTI interrupt and timestamp the edges in software
+ */
+#define SCAN_START_CAPTURE 1
 
 #define SEG_A_Pin 	GPIO_PIN_0
 #define SEG_B_Pin 	GPIO_PIN_1
@@ -71,18 +71,35 @@ void SystemClock_Config(void);
 #define OLED_CS_GPIO_Port GPIOB
 #define OLED_RST_GPIO_Port GPIOB
 
-extern volatile uint32_t vfd_scan_period; /** interval between scan pin interrupts, in sys clocks */
-extern volatile uint32_t vfd_curr_arr;	  /** timer auto reload register for current scan period */
-extern volatile uint32_t vfd_tim_arr;	  /** timer auto reload register modified by timer */
+extern volatile uint32_t vfd_scan_period; /** interval between scan pin interrupts, in usec */
+extern volatile uint32_t vfd_curr_arr;	  /** grid window for current scan period, in usec */
 extern volatile uint32_t vfd_wd;		  /** wfd watchdog timer, scan interrupt resets it to 0 */
+extern scan_queue_t vfd_queue;			  /** queue of scanned lines */
+extern render_queue_t render_queue;		  /** queue of decoded lines to render */
+extern stage_stats_t decode_stage;		  /** decode stage counters */
+extern stage_stats_t render_stage;		  /** render stage counters */
+extern vfd_pll_t vfd_pll;				  /** phase-locked scan scheduler */
+extern volatile uint32_t vfd_isr_clocks;  /** sys clocks spent in scanner interrupts during the last scan cycle */
+extern volatile uint8_t  vfd_oversample;  /** number of samples per digit for majority vote, 1 to disable */
+extern volatile uint32_t vfd_vote_bits;	  /** number of segment bits corrected by majority vote */
+extern volatile uint32_t vfd_vote_scans;  /** number of scan cycles with corrected bits */
 
 #define VFD_WD_TIMEOUT 100 /** wfd watchdog timer interval in msec */
 
 #define APP_PRINT_ENABLE   0x01 /** enable debug output to serial port */
 #define APP_PRINT_HEX_SCAN 0x02 /** print hex scan codes */
 #define APP_PRINT_KEY_SCAN 0x04 /** print changes in key scans */
+#define APP_SCAN_COALESCE  0x08 /** skip to the newest scanned line if the main loop is behind */
+#define APP_RUN_STEADY     0x10 /** show a steady indicator instead of blinking while a program is running */
+#define APP_PRINT_BINARY   0x20 /** print scan lines as binary telemetry records, see lib/telemetry.h */
+
+#define APP_RUN_STEADY_RATE 4 /** blinks per second to switch to the steady indicator */
+#define APP_INFO_SETTLE 500 /** msec a value must stay on the display to be settled, see the OLED info line */
 
 extern uint8_t app_flags;
+extern uint32_t app_skipped; /** number of scanned lines skipped by APP_SCAN_COALESCE */
+extern uint32_t app_loop_max; /** the longest main loop iteration, sys clocks */
+extern uint16_t app_run_rate; /** display blinks per second while a program is running */
 
 #ifdef __cplusplus
 }
@@ -31,15 +31,24 @@ extern "C" {
 
 /* USER CODE END Includes */
 
+extern TIM_HandleTypeDef htim3;
 extern TIM_HandleTypeDef htim4;
 
 /* USER CODE BEGIN Private defines */
 
 /* USER CODE END Private defines */
 
+void MX_TIM3_Init(void);
 void MX_TIM4_Init(void);
 
 /* USER CODE BEGIN Prototypes */
+/** start capture of the scan pin rising edges on TIM3 channel 3 with interrupt */
+static inline void tim_capture_start(TIM_TypeDef *tim) {
+	tim->SR &= ~(TIM_SR_CC3IF | TIM_SR_CC3OF);
+	tim->DIER |= TIM_DIER_CC3IE;
+	tim->CCER |= TIM_CCER_CC3E;
+	tim->CR1 |= TIM_CR1_CEN;
+}
 
 /* USER CODE END Prototypes */
 
@@ -19,16 +19,30 @@ const char cmd_list[] =
 	"\n"
 	"reset\n"
 	"info\n"
+	"pipeline\n"	/* print and reset display pipeline counters */
 	"print scan on|off\n" /* enable scan output to serial port */
 	"print hex on|off\n"  /* enable raw scan in hex */
 	"print key on|off\n"  /* enable keyboard scan codes */
+	"print binary on|off\n" /* scan output as binary records, see tools/mk52tlm.py */
+	"scan oversample $n\n"	/* 1, 3, 5 or 7 samples per digit */
+	"scan phase\n"			/* print and reset phase error statistics */
+	"scan coalesce on|off\n" /* skip to the newest line if output is behind */
+	"serial baud $rate\n"	/* 2400 to 921600 */
+	"serial stats\n"		/* print and reset TX and RX counters, TX CPU and stall time */
 	"oled on|off\n"
 	"oled reset\n"
 	"oled clear [$color]\n" 	/* color 0x00 to 0x0F */
 	"oled font $color_value\n" 	/* 0: off, 15: max */
+	"oled contrast $value\n" 	/* 0 to 255 */
 	"oled print $str\n" 		/* print a string of valid symbols */
 	"oled line $start_line\n"  	/* 0 to 63 */
 	"oled rotate on|off\n"
+	"oled spi 8|16\n" 		/* SPI data frame size */
+	"oled rows $rows|64\n" 	/* number of driven rows: the frame rows, as shown by info, or all */
+	"oled running blink|steady\n" /* blink or show an indicator while a program is running */
+	"oled rate $hz\n" 		/* max flush rate, 0 for no limit */
+	"oled load\n" 			/* print and reset flush rate, SPI and CPU load */
+	"oled bench\n" 			/* compare full and partial frame flushes */
 ;
 
 /* mapping from a letter to a MK52 symbol */
@@ -55,11 +69,11 @@ int8_t cli(char *buf, void *ptr)
 		uint32_t *uid = ((uint32_t *)UID_BASE);
 		serial_puts("UID: ");
 		for(unsigned i = 0; i < 3; i++) {
-			serial_print("%08lX", uid[i]);
+			serial_print("%08X", (unsigned)uid[i]);
 			if (i < 2)
 				serial_puts("-");
 		}
-		serial_print("\nRunning at: %u", SystemCoreClock);
+		serial_print("\nRunning at: %u", (unsigned)SystemCoreClock);
 		serial_print("\nVersion: %s", version);
 		serial_print("Commands:");
 		for (const char *ptr = cmd_list; *ptr; ptr++) {
@@ -84,14 +98,94 @@ int8_t cli(char *buf, void *ptr)
 	}
 
 	if (str_is(cmd, "info")) {
-		serial_print("DWT counter is running at %u clocks per usec\n", clocks_per_usec);
-		serial_print("Scan cycle %u.%u msec\n", vfd_scan_period / 1000, vfd_scan_period % 1000);
-		serial_print("Timer period %u usec\n", vfd_curr_arr);
+		serial_print("DWT counter is running at %u clocks per usec\n", (unsigned)clocks_per_usec);
+		serial_print("Scan cycle %u.%u msec\n", (unsigned)(vfd_scan_period / 1000), (unsigned)(vfd_scan_period % 1000));
+		serial_print("Grid window %u usec\n", (unsigned)vfd_curr_arr);
+		if (vfd_scan_period) {
+			/* per mille of the scan cycle spent in the scanner interrupts */
+			uint32_t load = (vfd_isr_clocks * 1000) / (vfd_scan_period * clocks_per_usec);
+			serial_print("Scanner ISR %u clocks per cycle, %u.%u%% load\n", (unsigned)vfd_isr_clocks,
+						 (unsigned)(load / 10), (unsigned)(load % 10));
+		}
+		serial_print("Scan queue %u of %u lines, max %u, %u overruns\n", (unsigned)scanq_size(&vfd_queue),
+					 SCANQ_SIZE, (unsigned)vfd_queue.max_used, (unsigned)vfd_queue.overruns);
+		serial_print("Coalescing is %s, %u lines skipped\n",
+					 is_on(app_flags & APP_SCAN_COALESCE), (unsigned)app_skipped);
+		serial_print("Oversampling x%u, %u bits corrected in %u scans\n",
+					 vfd_oversample, (unsigned)vfd_vote_bits, (unsigned)vfd_vote_scans);
+		serial_print("Main loop max %u usec\n", (unsigned)(app_loop_max / clocks_per_usec));
+		app_loop_max = 0;
+		serial_print("OLED %u rows, %u bit SPI, flush %u bytes in %u regions, %u usec, %u usec copy\n",
+					 oled_is_glyph_rows() ? OLED_FRAME_HEIGHT : OLED_HEIGHT, oled_is_spi16() ? 16 : 8, (unsigned)oled_stats.bytes,
+					 oled_stats.regions, (unsigned)(oled_stats.clocks / clocks_per_usec), (unsigned)(oled_stats.copy_clocks / clocks_per_usec));
+#if OLED_INFO_LINE
+		serial_print("OLED info line %u of %u bytes, render %u of %u clocks\n", (unsigned)oled_stats.info_bytes,
+					 (unsigned)oled_stats.bytes, (unsigned)oled_stats.info_clocks, (unsigned)oled_stats.render_clocks);
+#endif
+		serial_print("Program running: %u blinks/s, %s\n", app_run_rate,
+					 (app_flags & APP_RUN_STEADY) ? "steady" : "blink");
 		serial_print("Printing of hex scan codes is %s\n", is_on(app_flags & APP_PRINT_HEX_SCAN));
 		serial_print("Printing of key scan codes is %s\n", is_on(app_flags & APP_PRINT_KEY_SCAN));
 		return CLI_EOK;
 	}
 
+	if (str_is(cmd, "pipeline")) {
+		const stage_stats_t *stage[] = { &decode_stage, &render_stage };
+		static const char *name[] = { "decode", "render" };
+		serial_print("scan queue: %u of %u lines, max %u, %u overruns\n", (unsigned)scanq_size(&vfd_queue),
+					 SCANQ_SIZE, (unsigned)vfd_queue.max_used, (unsigned)vfd_queue.overruns);
+		serial_print("render queue: %u of %u jobs, max %u, %u merged\n", (unsigned)renderq_size(&render_queue),
+					 RENDERQ_SIZE, (unsigned)render_queue.max_used, (unsigned)render_queue.merged);
+		/* latencies are counted from posting a scanned line */
+		for (uint8_t i = 0; i < 2; i++) {
+			serial_print("%s: %u lines, latency avg %u max %u usec\n", name[i], (unsigned)stage[i]->items,
+						 (unsigned)(stage_lat_avg(stage[i]) / clocks_per_usec), (unsigned)(stage[i]->lat_max / clocks_per_usec));
+		}
+		/* flush latency is counted from marking the first dirty region */
+		uint32_t flush_avg = oled_load.flushes ? oled_load.lat_sum / oled_load.flushes : 0;
+		serial_print("flush: %u frames, latency avg %u max %u usec\n", (unsigned)oled_load.flushes,
+					 (unsigned)(flush_avg / clocks_per_usec), (unsigned)(oled_load.lat_max / clocks_per_usec));
+		memset(&decode_stage, 0, sizeof(decode_stage));
+		memset(&render_stage, 0, sizeof(render_stage));
+		render_queue.max_used = render_queue.merged = 0;
+		oled_load_reset();
+		return CLI_EOK;
+	}
+
+	if (str_is(cmd, "serial")) {
+		if (str_is(arg, "baud")) {
+			arg = get_arg(arg);
+			uint32_t baud = strtoul(arg, NULL, 10);
+			if (baud < UART_BR_2400 || baud > UART_BR_921600)
+				return CLI_EARG;
+			serial_print("switching to %u baud\n", (unsigned)baud);
+			serial_set_baud(baud);
+			return CLI_EOK;
+		}
+		if (str_is(arg, "stats")) {
+			/* take a snapshot, printing adds to the counters */
+			serial_stats_t st = serial_stats;
+			uint32_t ms = millis() - st.start;
+			serial_stats_reset();
+			if (!ms)
+				return CLI_EOK;
+			/* load in 0.1% */
+			uint32_t cpu = st.tx_clocks / (ms * clocks_per_usec);
+			serial_print("%u baud, TX by %s: %u bytes in %u ms, %u interrupts, %u/s, %u clocks each, CPU %u.%u%%\n",
+						 (unsigned)serial_get_baud(), SERIAL_TX_DMA ? "DMA" : "TXE", (unsigned)st.tx_bytes, (unsigned)ms,
+						 (unsigned)st.tx_irqs, (unsigned)(st.tx_irqs * 1000 / ms),
+						 (unsigned)(st.tx_irqs ? st.tx_clocks / st.tx_irqs : 0), (unsigned)(cpu / 10), (unsigned)(cpu % 10));
+			serial_print("RX by %s: %u bytes in %u bursts, %u dropped, %u skips, errors: %u overrun, %u framing, %u noise\n",
+						 SERIAL_RX_DMA ? "DMA" : "RXNE", (unsigned)st.rx_bytes, (unsigned)st.rx_bursts,
+						 (unsigned)st.rx_dropped, (unsigned)st.rx_skips, (unsigned)st.rx_overruns, (unsigned)st.rx_framing, (unsigned)st.rx_noise);
+			serial_print("TX stalls: %u, %u us, the longest %u us, scan log: %u lines, %u dropped, %u clocks each\n",
+						 (unsigned)st.tx_stalls, (unsigned)(st.tx_stall_clocks / clocks_per_usec), (unsigned)(st.tx_stall_max / clocks_per_usec),
+						 (unsigned)st.log_records, (unsigned)st.log_dropped, (unsigned)(st.log_records ? st.log_clocks / st.log_records : 0));
+			return CLI_EOK;
+		}
+		return CLI_EARG;
+	}
+
 	if (str_is(cmd, "print")) {
 		uint8_t flag = 0;
 		if (str_is(arg, "scan"))
@@ -100,6 +194,8 @@ int8_t cli(char *buf, void *ptr)
 			flag = APP_PRINT_HEX_SCAN;
 		else if (str_is(arg, "key"))
 			flag = APP_PRINT_KEY_SCAN;
+		else if (str_is(arg, "binary"))
+			flag = APP_PRINT_BINARY;
 		else
 			return CLI_EARG;
 		arg = get_arg(arg);
@@ -112,6 +208,44 @@ int8_t cli(char *buf, void *ptr)
 		return CLI_EOK;
 	}
 
+	if (str_is(cmd, "scan")) {
+		if (str_is(arg, "oversample")) {
+			arg = get_arg(arg);
+			uint16_t num = argtou(arg, &arg);
+			if (!(num & 0x01) || num > VFD_VOTE_MAX)
+				return CLI_EARG;
+			vfd_oversample = num; /* will be used at the next scan cycle */
+			vfd_vote_bits = vfd_vote_scans = 0;
+			return CLI_EOK;
+		}
+		if (str_is(arg, "coalesce")) {
+			arg = get_arg(arg);
+			if (str_is(arg, "on"))
+				app_flags |= APP_SCAN_COALESCE;
+			else if (str_is(arg, "off"))
+				app_flags &= ~APP_SCAN_COALESCE;
+			else
+				return CLI_EARG;
+			return CLI_EOK;
+		}
+
+		if (str_is(arg, "phase")) {
+			vfd_pll_t pll = vfd_pll;
+			vfd_pll_reset_stats(&vfd_pll);
+			if (!pll.err_num) {
+				serial_puts("no samples\n");
+				return CLI_EOK;
+			}
+			serial_print("Period %u.%02u clocks, window %u clocks, latency %d clocks\n",
+						 (unsigned)(pll.period >> VFD_PLL_FRAC), (unsigned)(((pll.period & 0xFF) * 100) >> VFD_PLL_FRAC),
+						 (unsigned)(pll.window >> VFD_PLL_FRAC), (int)(pll.latency >> VFD_PLL_FRAC));
+			serial_print("Phase error min %d, max %d, avg %u clocks in %u samples\n",
+						 (int)pll.err_min, (int)pll.err_max, (unsigned)(pll.err_abs / pll.err_num), (unsigned)pll.err_num);
+			return CLI_EOK;
+		}
+		return CLI_EARG;
+	}
+
 	if (str_is(cmd, "oled")) {
 		if (str_is(arg, "font")) {
 			arg = get_arg(arg);
@@ -122,6 +256,15 @@ int8_t cli(char *buf, void *ptr)
 			return CLI_EOK;
 		}
 
+		if (str_is(arg, "contrast")) {
+			arg = get_arg(arg);
+			uint16_t contrast = argtou(arg, &arg);
+			if (contrast > 0xFF)
+				return CLI_EARG;
+			oled_set_contrast(contrast);
+			return CLI_EOK;
+		}
+
 		if (str_is(arg, "line")) {
 			arg = get_arg(arg);
 			uint16_t line = argtou(arg, &arg);
@@ -143,6 +286,140 @@ int8_t cli(char *buf, void *ptr)
 			return CLI_EOK;
 		}
 
+		if (str_is(arg, "bench")) {
+			static const char *name[] = { "full frame", "one digit", "dot only", "8. to 9.", "sign", "all digits",
+#if OLED_INFO_LINE
+										  "info digit",
+#endif
+			};
+			bool spi16 = oled_is_spi16();
+			serial_print("Cell frame, %u bytes of RAM\n", (unsigned)oled_frame_ram());
+			for (uint8_t mode = 0; mode < 2; mode++) {
+				oled_set_spi16(mode);
+				uint32_t ts = DWT->CYCCNT;
+				oled_clear_ram(OLED_DEFAULT_BKG_COLOR);
+				oled_flush_wait();
+				ts = DWT->CYCCNT - ts;
+				serial_print("%u bit SPI, RAM clear %u usec\n", mode ? 16 : 8, (unsigned)(ts / clocks_per_usec));
+				oled_invalidate(); /* make sure that every print below changes the frame */
+				for (uint8_t test = 0; test < sizeof(name) / sizeof(name[0]); test++) {
+					switch(test) {
+					case 0:
+						oled_mark_dirty(0, 0, OLED_LINE_SIZE, OLED_FRAME_HEIGHT);
+						break;
+					case 1:
+						oled_print(1, SYM_8);
+						break;
+					case 2:
+						oled_print(1, SYM_8 | SEG_DOT);
+						break;
+					case 3: /* only segment E is changed */
+						oled_print(1, SYM_9 | SEG_DOT);
+						break;
+					case 4:
+						oled_print(0, SYM_MINUS);
+						break;
+					case 5:
+						for (uint8_t pos = 1; pos < OLED_DIGITS; pos++)
+							oled_print(pos, SYM_0 + pos % 10);
+						break;
+#if OLED_INFO_LINE
+					case 6: { /* one digit of the info line, the digits are not sent */
+						uint8_t info[OLED_DIGITS] = { 0 };
+						oled_print_info(info); /* the whole line after oled_invalidate() */
+						oled_flush_frame();
+						info[1] = SEG_A | SEG_B | SEG_C | SEG_D | SEG_E | SEG_F | SEG_G; /* 8 */
+						oled_print_info(info);
+						break;
+					}
+#endif
+					}
+					oled_flush_frame();
+					serial_print("%-10s: %4u bytes in %u regions, %u usec, render %u clocks\n", name[test],
+								 (unsigned)oled_stats.bytes, oled_stats.regions, (unsigned)(oled_stats.clocks / clocks_per_usec),
+								 (unsigned)oled_stats.render_clocks);
+				}
+			}
+			/* RAM clear of the driven rows only and of the whole RAM */
+			bool glyph_rows = oled_is_glyph_rows();
+			for (uint8_t mode = 0; mode < 2; mode++) {
+				oled_set_glyph_rows(mode);
+				oled_flush_wait();
+				uint32_t ts = DWT->CYCCNT;
+				oled_clear_ram(OLED_DEFAULT_BKG_COLOR);
+				oled_flush_wait();
+				ts = DWT->CYCCNT - ts;
+				serial_print("%u rows, RAM clear %u usec\n", mode ? OLED_FRAME_HEIGHT : OLED_HEIGHT,
+							 (unsigned)(ts / clocks_per_usec));
+			}
+			oled_set_glyph_rows(glyph_rows);
+			oled_set_spi16(spi16);
+			oled_invalidate(); /* the next scanned line will restore all digits */
+			return CLI_EOK;
+		}
+
+		if (str_is(arg, "rate")) {
+			arg = get_arg(arg);
+			uint16_t rate = argtou(arg, &arg);
+			if (rate > 1000)
+				return CLI_EARG;
+			oled_set_flush_rate(rate);
+			oled_load_reset();
+			return CLI_EOK;
+		}
+
+		if (str_is(arg, "load")) {
+			uint32_t ms = millis() - oled_load.start;
+			if (!ms)
+				return CLI_EOK;
+			/* loads in 0.1% */
+			uint32_t window = ms * clocks_per_usec;
+			uint32_t spi = oled_load.spi_clocks / window;
+			uint32_t cpu = oled_load.cpu_clocks / window;
+			serial_print("Flush rate limit %u Hz, %u flushes in %u ms, SPI %u.%u%%, CPU %u.%u%%\n",
+						 oled_get_flush_rate(), (unsigned)oled_load.flushes, (unsigned)ms,
+						 (unsigned)(spi / 10), (unsigned)(spi % 10), (unsigned)(cpu / 10), (unsigned)(cpu % 10));
+#if OLED_INFO_LINE
+			/* the info line share of sent bytes and its own CPU load */
+			uint32_t share = oled_load.bytes ? (oled_load.info_bytes * 1000) / oled_load.bytes : 0;
+			cpu = oled_load.info_clocks / window;
+			serial_print("Info line %u.%u%% of %u bytes, CPU %u.%u%%\n", (unsigned)(share / 10), (unsigned)(share % 10),
+						 (unsigned)oled_load.bytes, (unsigned)(cpu / 10), (unsigned)(cpu % 10));
+#endif
+			oled_load_reset();
+			return CLI_EOK;
+		}
+
+		if (str_is(arg, "running")) {
+			arg = get_arg(arg);
+			if (str_is(arg, "steady"))
+				app_flags |= APP_RUN_STEADY;
+			else if (str_is(arg, "blink"))
+				app_flags &= ~APP_RUN_STEADY;
+			else
+				return CLI_EARG;
+			return CLI_EOK;
+		}
+
+		if (str_is(arg, "rows")) {
+			arg = get_arg(arg);
+			uint16_t rows = argtou(arg, &arg);
+			if (rows != OLED_FRAME_HEIGHT && rows != OLED_HEIGHT)
+				return CLI_EARG;
+			oled_set_glyph_rows(rows == OLED_FRAME_HEIGHT);
+			oled_invalidate(); /* the next scanned line will restore all digits */
+			return CLI_EOK;
+		}
+
+		if (str_is(arg, "spi")) {
+			arg = get_arg(arg);
+			uint16_t bits = argtou(arg, &arg);
+			if (bits != 8 && bits != 16)
+				return CLI_EARG;
+			oled_set_spi16(bits == 16);
+			return CLI_EOK;
+		}
+
 		if (str_is(arg, "reset")) {
 			oled_init(OLED_DEFAULT_BKG_COLOR);
 			return CLI_EOK;
@@ -156,6 +433,7 @@ int8_t cli(char *buf, void *ptr)
 			if (fill > 0x0F)
 				return CLI_EARG;
 			oled_clear_ram(fill);
+			oled_invalidate(); /* the next scanned line will restore all digits */
 			return CLI_EOK;
 		}
 
@@ -178,6 +456,7 @@ int8_t cli(char *buf, void *ptr)
 			for (; pos < OLED_DIGITS; pos++)
 				oled_print(pos, SYM_SPACE);
 			oled_flush_frame();
+			oled_invalidate(); /* the next scanned line will restore all digits */
 			return CLI_EOK;
 		}
 
@@ -0,0 +1,52 @@
+/**
+  ******************************************************************************
+  * @file    dma.c
+  * @brief   This file provides code for the configuration
+  *          of all the requested memory to memory DMA transfers.
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2021 STMicroelectronics.
+  * All rights reserved.</center></h2>
+  *
+  * This software component is licensed by ST under BSD 3-Clause license,
+  * the "License"; You may not use this file except in compliance with the
+  * License. You may obtain a copy of the License at:
+  *                        opensource.org/licenses/BSD-3-Clause
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "dma.h"
+
+/* USER CODE BEGIN 0 */
+
+/* USER CODE END 0 */
+
+/*----------------------------------------------------------------------------*/
+/* Configure DMA                                                              */
+/*----------------------------------------------------------------------------*/
+
+/**
+  * Enable DMA controller clock
+  */
+void MX_DMA_Init(void)
+{
+	/* DMA controller clock enable */
+	__HAL_RCC_DMA1_CLK_ENABLE();
+
+	/* DMA interrupt init */
+	/* DMA1_Channel7_IRQn interrupt configuration: TIM4_UP segments capture */
+	HAL_NVIC_SetPriority(SCAN_DMA_IRQn, 0, 0);
+	HAL_NVIC_EnableIRQ(SCAN_DMA_IRQn);
+	/* DMA1_Channel5_IRQn interrupt configuration: SPI2_TX OLED flush, must not delay the scanner */
+	HAL_NVIC_SetPriority(OLED_DMA_IRQn, 2, 0);
+	HAL_NVIC_EnableIRQ(OLED_DMA_IRQn);
+}
+
+/* USER CODE BEGIN 2 */
+
+/* USER CODE END 2 */
+
+/************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
@@ -67,11 +67,13 @@ void MX_GPIO_Init(void)
 	GPIO_InitStruct.Pull = GPIO_NOPULL;
 	HAL_GPIO_Init(SEG_GPIO_Port, &GPIO_InitStruct);
 
-	/* Configure GPIO GRID pin for scanning start interrupt */
+#if !SCAN_START_CAPTURE
+	/* Configure GPIO GRID pin for scanning start interrupt, TIM3 MSP init takes care of it otherwise */
 	GPIO_InitStruct.Pin = SCAN_Pin;
 	GPIO_InitStruct.Mode = GPIO_MODE_IT_RISING;
 	GPIO_InitStruct.Pull = GPIO_NOPULL;
 	HAL_GPIO_Init(SCAN_GPIO_Port, &GPIO_InitStruct);
+#endif
 
 	/* Configure GPIO OLED CS, DC and RST pins */
 	GPIO_InitStruct.Pin = OLED_DC_Pin | OLED_CS_Pin | OLED_RST_Pin;
@@ -79,9 +81,11 @@ void MX_GPIO_Init(void)
 	GPIO_InitStruct.Pull = GPIO_PULLUP;
 	HAL_GPIO_Init(OLED_DC_GPIO_Port, &GPIO_InitStruct);
 
+#if !SCAN_START_CAPTURE
 	/* EXTI interrupt init for GRID_8 pin */
 	HAL_NVIC_SetPriority(EXTI0_IRQn, 0, 0);
 	HAL_NVIC_EnableIRQ(EXTI0_IRQn);
+#endif
 }
 
 /************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
@@ -1,19 +1,24 @@
 /**
  * MIT License
  */
+#include <string.h>
+
 #include "main.h"
+#include "dma.h"
 #include "spi.h"
 #include "tim.h"
 #include "gpio.h"
 
-#include "lib/ringbuf.h"
+#include "lib/scanq.h"
+#include "lib/renderq.h"
 #include "lib/serial.h"
 #include "lib/serial_cli.h"
 #include "lib/oled.h"
+#include "lib/telemetry.h"
 
 #define ENABLE_DEBUG_PRINT   1 /* by default print scan results to the serial port */
 #define DEBUG_VIRTUAL_DIGITS 0 /* print digits 13 & 14 */
-#define SCAN_START_DELAY     2 /* delay in mks for lines to stabilize */
+#define SCAN_USE_DMA         1 /* capture segments by DMA on TIM4 update instead of TIM4 interrupt */
 
 #define OLED_OUTPUT_ENABLED   1 /* use OLED for output */
 #define OLED_DEMO_DIGITS_FONT 1 /* OLED demo output */
@@ -23,38 +28,11 @@
 #define OLED_DEMO_DIGITS_FONT 0 /* disable demo if OLED is used for output */
 #endif
 
-#define OLED_DIGITS_PLACEHOLDERS_COLOR 0x00 /* draw OLED digits placeholders */
-
-#define NUM_DIGITS OLED_DIGITS 	/* 12 real digit positions */
-#define NUM_VIRT   2		  	/* 2 virtual digit positions */
-#define NUM_SCAN_POS (NUM_DIGITS + NUM_VIRT) /* 12 real digit positions and 2 virtual */
-#define PROGRAM_RUNNING 0x6F /* '9' at virtual position 0 as a running program flag */
-
-typedef struct scan_s {
-	union {
-		uint8_t scan_buf[NUM_SCAN_POS]; /** one line of scanned segments codes */
-		struct {
-			uint8_t digits[NUM_DIGITS]; /** digit scans */
-			uint8_t key[NUM_VIRT];      /** key scans */
-		};
-	};
-	uint16_t scan_time; /** number of scan intervals before detecting this line */
-} scan_t;
-
-#define NUM_LINES 16
-scan_t vfd[NUM_LINES]; /** ring buffer for scanned digits */
-
-#define LINE_TYPE_NORMAL 0x80
-#define LINE_TYPE_IDLE   0x40
-#define LINE_TYPE_EXEC   0x20
-
 /**
- * ring buffer for event generated by VFD scanner per scanned line
- * high nibble contains LINE_TYPE_*
- * low nibble contains line number for vfd[]
+ * queue of lines generated by VFD scanner, line_type of a line tells
+ * if it is a normal line or detected program execution, or all digits are off
  */
-ring_buf_t evbuf;
-uint8_t vfd_events[32];
+scan_queue_t vfd_queue;
 
 /**
  * map table from a scan code to the sequencial index of supported symbols
@@ -89,15 +67,179 @@ static const uint8_t seg_sym[] = {
 	'?', ' ', '-', '0', '1', '2', '3', '4', '5', '6', '7', '8', '9',
 	'C', 'E', 'L', 'R', '{', 'F', 'P' };
 
+/* printable text of a scan code: symbol with optional dot or hex code in brackets */
+static void scan_to_text(char *text, uint8_t scan)
+{
+	static const char hex[] = "0123456789ABCDEF";
+	uint8_t sym = seg_map[scan & 0x7F];
+	if (sym) {
+		*text++ = seg_sym[sym];
+		if (scan & SEG_DOT)
+			*text++ = '.';
+	} else {
+		*text++ = '(';
+		*text++ = hex[scan >> 4];
+		*text++ = hex[scan & 0x0F];
+		*text++ = ')';
+	}
+	*text = '\0';
+}
+
+/* printable text of every scan position, updated only if the position changes */
+static char seg_text[NUM_SCAN_POS][5];
+
+/**
+ * the longest scan log records, see serial_log_begin(): a blank line is printed
+ * when the display goes off and completed by the number of blank cycles when it is back
+ */
+#define LOG_BLANK_LEN  15 /* quotes around spaces */
+#define LOG_CYCLES_MAX sizeof(" 65535 cycles (4294967,295 ms)\r\n")
+#define LOG_SCAN_MAX   (NUM_SCAN_POS * 3 + 1 + NUM_SCAN_POS * 4 + 4 + \
+						sizeof(" RUNNIG") + sizeof(" (4294967295 skipped)") + 2)
+
+/**
+ * binary telemetry, see telemetry.h: records carry changes since the previous sent one,
+ * so changes of a dropped record are sent with the next one
+ */
+static uint8_t tlm_seq;
+static uint16_t tlm_pending = TLM_ALL_POS;
+
 /** application flags controlled by CLI */
 #if ENABLE_DEBUG_PRINT
 uint8_t app_flags = APP_PRINT_ENABLE;
 #else
 uint8_t app_flags = 0;
 #endif
+uint32_t app_skipped;
+uint32_t app_loop_max;
+uint16_t app_run_rate;
+
+/**
+ * display pipeline: scanned lines are decoded to render jobs, jobs are rendered
+ * to the symbol cells and the frame is flushed by DMA, every stage runs as soon as
+ * it has input, so decode and render of the next frame go on while the previous one is sent
+ */
+render_queue_t render_queue;
+stage_stats_t decode_stage; /* from posting a scanned line to its decoding */
+stage_stats_t render_stage; /* from posting a scanned line to rendering of its job */
+
+static bool run_steady;      /* true if the running indicator is shown instead of blinking */
+static uint16_t run_blinks;  /* program running blinks in the current second */
 
 static ticker_t tick10ms;
 
+/* send a scanned line as a binary telemetry record, if there is room in the TX buffer */
+static void log_binary(const scan_t *line, uint32_t skipped, bool blank)
+{
+	uint8_t frame[TLM_FRAME_MAX];
+	uint8_t seq = tlm_seq++; /* gaps tell a receiver about dropped records */
+	tlm_event_t ev = {
+		.type = line->line_type,
+		.stamp = millis(),
+		.scan = line->scan_buf,
+	};
+
+	tlm_pending |= line->changed;
+	if (line->line_type & LINE_TYPE_NORMAL) {
+		ev.mask = tlm_pending;
+		if (app_flags & APP_PRINT_HEX_SCAN)
+			ev.type |= TLM_HEX;
+		if (skipped) {
+			ev.type |= TLM_SKIPPED;
+			ev.skipped = skipped;
+		}
+		if (blank) {
+			ev.type |= TLM_BLANK;
+			ev.cycles = line->scan_time;
+			ev.blank = line->scan_time * vfd_scan_period;
+		}
+	}
+	if (!serial_log_begin(TLM_FRAME_MAX))
+		return;
+	serial_write(frame, tlm_frame(frame, seq, &ev));
+	serial_log_end();
+	tlm_pending &= ~ev.mask;
+}
+
+#if OLED_OUTPUT_ENABLED && OLED_INFO_LINE
+/**
+ * the info line shows the previous settled value: a value is settled when it stays
+ * on the display for APP_INFO_SETTLE msec while no program is running,
+ * so digits being typed and values flashing by while calculating are skipped
+ */
+static uint8_t info_shown[NUM_DIGITS];   /* digits of the last normal line */
+static uint8_t info_settled[NUM_DIGITS]; /* the last settled value */
+static uint8_t info_prev[NUM_DIGITS];    /* the settled value before it, shown by the info line */
+static uint32_t info_changed;            /* millis() of the last change, 0 if settled */
+
+static void info_update(const uint8_t *digits, uint8_t line_type)
+{
+	if (line_type & LINE_TYPE_EXEC) {
+		info_changed = 0; /* values of a running program are not settled */
+		return;
+	}
+	if (memcmp(info_shown, digits, NUM_DIGITS)) {
+		memcpy(info_shown, digits, NUM_DIGITS);
+		info_changed = millis() | 1;
+	}
+}
+
+/* push the settled value to the info line, only its changed segments are sent */
+static void info_poll(void)
+{
+	if (!info_changed || (millis() - info_changed) < APP_INFO_SETTLE)
+		return;
+	info_changed = 0;
+	if (memcmp(info_settled, info_shown, NUM_DIGITS)) {
+		memcpy(info_prev, info_settled, NUM_DIGITS);
+		memcpy(info_settled, info_shown, NUM_DIGITS);
+		oled_print_info(info_prev);
+	}
+}
+#endif
+
+#if OLED_OUTPUT_ENABLED
+/* render all queued jobs to the frame, it is flushed by oled_flush_poll() */
+static void render_jobs(void)
+{
+	static uint16_t pending = DIGITS_MASK; /* positions changed since the last print */
+	render_job_t *job;
+
+	while ((job = renderq_peek(&render_queue)) != NULL) {
+		uint8_t line_type = job->line_type;
+		pending |= job->mask;
+		if (line_type & LINE_TYPE_NORMAL) {
+			/* if a program is running then dim the display, symbols in the frame are kept */
+			oled_set_dimmed(line_type & LINE_TYPE_EXEC);
+			oled_set_indicator(run_steady && (line_type & LINE_TYPE_EXEC));
+			oled_set_blanked(false);
+			oled_print_seg_mask(job->syms, pending);
+#if OLED_INFO_LINE
+			info_update(job->syms, line_type);
+			oled_print_info(info_prev); /* nothing to print unless the frame was cleared */
+#endif
+			pending = 0;
+		} else if (line_type & LINE_TYPE_IDLE) {
+			/**
+			 * blank the display by a command, the frame is kept and shown
+			 * again by the next normal line, so blinking of a running program
+			 * costs a couple of command bytes. If it blinks fast enough
+			 * then a steady running indicator can be shown instead
+			 */
+			if (line_type & LINE_TYPE_EXEC) {
+				run_blinks++;
+				run_steady = (app_flags & APP_RUN_STEADY) && app_run_rate >= APP_RUN_STEADY_RATE;
+				oled_set_indicator(run_steady);
+				oled_set_blanked(!run_steady);
+			} else
+				oled_set_blanked(true);
+		}
+		stage_account(&render_stage, DWT->CYCCNT - job->stamp);
+		renderq_release(&render_queue);
+	}
+}
+#endif
+
 int main(void)
 {
 	/* Reset of all peripherals, Initializes the Flash interface and the Systick. */
@@ -107,7 +249,10 @@ int main(void)
 	/* Initialize all configured peripherals */
 	/* initialize DWT for usec resolution delays, will set clocks_per_usec */
 	delay_usec_init();
+	/* scan cycles shorter than 1 msec are ignored: MK52 is starting up */
+	vfd_pll_init(&vfd_pll, 1000 * clocks_per_usec);
 	MX_GPIO_Init();
+	MX_DMA_Init();
 	/* use HAL init procedure, but then use registers directly for better speed */
 	MX_SPI2_Init();
 	spi->CR1 |= SPI_CR1_SPE; /* enable SPI */
@@ -116,8 +261,14 @@ int main(void)
 	MX_TIM4_Init();
 	/* clear Update Interrupt Flag, to get the first interrupt at needed interval */
 	__HAL_TIM_CLEAR_FLAG(&htim4, TIM_SR_UIF);
+#if SCAN_START_CAPTURE
+	/* scan pin edges are captured by TIM3, replaces EXTI interrupt */
+	MX_TIM3_Init();
+	tim_capture_start(TIM3);
+#endif
 
-	rbuf_init(&evbuf, vfd_events, 32);
+	scanq_init(&vfd_queue);
+	renderq_init(&render_queue);
 	/* do not use MX_USART3_UART_Init(); --> replaced with serial_init() */
 	serial_init(UART_BR_38400);
 
@@ -133,19 +284,10 @@ int main(void)
 	 * STM32 + OLED set to '-8.8.8.8.8.8.8.8.8.8.8." = 85mA
 	 */
 	oled_init(OLED_DEFAULT_BKG_COLOR);
-	sh1122_set_start_line(OLED_START_LINE);
 
 	ticker_init(&tick10ms, 10);
-
-#if OLED_DIGITS_PLACEHOLDERS_COLOR
-	oled_draw_line(0, 0, OLED_WIDTH, OLED_DIGITS_PLACEHOLDERS_COLOR); /* top */
-	oled_draw_line(0, OLED_FONT_HEIGHT - 1, OLED_WIDTH, OLED_DIGITS_PLACEHOLDERS_COLOR); /* bottom */
-	oled_draw_row(0, 1, OLED_FONT_HEIGHT - 2, OLED_DIGITS_PLACEHOLDERS_COLOR); /* sign placeholder */
-	oled_draw_row(9, 1, OLED_FONT_HEIGHT - 2, OLED_DIGITS_PLACEHOLDERS_COLOR);
-	for (uint16_t row = OLED_SYM_OFFSET - 1; row < OLED_WIDTH; row += OLED_FONT_WIDTH) /* symbols placeholders */
-		oled_draw_row(row, 1, OLED_FONT_HEIGHT - 2, OLED_DIGITS_PLACEHOLDERS_COLOR);
-	oled_flush_frame();
-#endif
+	ticker_t tick_run; /* program running blinks are counted every second */
+	ticker_init(&tick_run, 1000);
 
 #if OLED_DEMO_DIGITS_FONT
 	static ticker_t tick1s;
@@ -157,8 +299,11 @@ int main(void)
 #endif
 
 	bool blank = false; /* true if previous line was blank */
+	bool blank_logged = false; /* true if the blank line was printed and is to be completed */
+	uint16_t text_pending = (1u << NUM_SCAN_POS) - 1; /* positions changed since the last serial print */
 	/* the main  loop */
 	while (true) {
+		uint32_t loop_start = DWT->CYCCNT;
 		cli_interact(cli, NULL);
 
 #if OLED_DEMO_DIGITS_FONT
@@ -182,217 +327,325 @@ int main(void)
 #if OLED_OUTPUT_ENABLED
 		if (ticker_tick(&tick10ms))
 			vfd_wd++;
+		if (ticker_tick(&tick_run)) {
+			app_run_rate = run_blinks;
+			run_blinks = 0;
+		}
 
 		if (vfd_wd == (VFD_WD_TIMEOUT / 10)) {
 			oled_clear_frame(0);
 			oled_flush_frame();
-			sh1122_set_oled_on(false);
+			oled_set_blanked(true); /* turned on by the next normal line */
 		}
 #endif
 		/**
-		 * display scanner will send an event
-		 * bits 7..6 - scan line type: normal or detected program execution
-		 * bits 5..0 - scan buffer line index to read
-		 * if all bits are 0 then all digits are off
+		 * display scanner will send a line, line type tells if
+		 * it is normal or detected program execution, or all digits are off.
+		 * Every line is taken by default, so the serial log sees all of them,
+		 * display latency is bounded by merging of render jobs when the render
+		 * queue is full. With coalescing on, skip to the newest line instead,
+		 * for when the decode and print of every line cannot keep up
 		 */
-		if (rbuf_size(&evbuf)) {
-			uint8_t i, line;
-			uint8_t line_type = rbuf_read(&evbuf);
-			if (line_type & LINE_TYPE_NORMAL) {
-				line = line_type & ~(LINE_TYPE_NORMAL | LINE_TYPE_IDLE | LINE_TYPE_EXEC);
+		uint32_t skipped = 0;
+		scan_t *line;
+		if (app_flags & APP_SCAN_COALESCE)
+			line = scanq_peek_latest(&vfd_queue, &skipped);
+		else
+			line = scanq_peek(&vfd_queue);
+		if (line) {
+			app_skipped += skipped;
+			uint8_t i;
+			uint8_t line_type = line->line_type;
+			text_pending |= line->changed;
 #if OLED_OUTPUT_ENABLED
-				/* if a program is running then set color to dimmest one */
-				oled_set_font_color((line_type & LINE_TYPE_EXEC) ? OLED_COLOR_DIM : OLED_DEFAULT_FONT_COLOR);
-				/* print to oled frame buffer */
-				for (i = 0; i < NUM_DIGITS; i++) {
-					uint8_t scan = vfd[line].scan_buf[i];
-					if (i == 0) { /* only G segment is valid for the sign */
-						oled_print(0, (scan & SEG_G) ? SYM_MINUS : SYM_SPACE);
-						continue;
-					} else {
-						uint8_t sym = seg_map[scan & 0x7F]; /* 0: invalid, else symbol index + 1 */
-						if (sym <= 1) {
-							oled_print(i, (scan & SEG_DOT) | SYM_SPACE);
-							continue;
-						}
-						oled_print(i, (scan & SEG_DOT) | (sym - 1));
-					}
-				}
-				oled_flush_frame();
-#endif
-				if (blank) {
-#if OLED_OUTPUT_ENABLED
-					sh1122_set_oled_on(true);
+			/* decode the line to a render job */
+			if (line_type & LINE_TYPE_NORMAL) {
+				/* scan codes are drawn as they are, unknown symbols included */
+				renderq_push(&render_queue, line->digits, line->changed & DIGITS_MASK, line_type, line->stamp);
+			} else if (line_type & LINE_TYPE_IDLE)
+				renderq_push(&render_queue, NULL, line->changed & DIGITS_MASK, line_type, line->stamp);
+			stage_account(&decode_stage, DWT->CYCCNT - line->stamp);
 #endif
-					if (app_flags & APP_PRINT_ENABLE) {
-						uint32_t cycle_time = (vfd_curr_arr + 1) * NUM_SCAN_POS;
-						serial_print(" %u cycles (%u,%u ms)\n", vfd[line].scan_time,
-									 (vfd[line].scan_time * cycle_time) / 1000,
-									 (vfd[line].scan_time * cycle_time) % 1000);
-					}
+			bool print_text = (app_flags & APP_PRINT_ENABLE) && !(app_flags & APP_PRINT_BINARY);
+			if ((app_flags & APP_PRINT_ENABLE) && (app_flags & APP_PRINT_BINARY)) {
+				if (line_type & (LINE_TYPE_NORMAL | LINE_TYPE_IDLE))
+					log_binary(line, skipped, blank);
+			} else
+				tlm_pending = TLM_ALL_POS; /* binary output starts with all positions */
+			if (line_type & LINE_TYPE_NORMAL) {
+				/* the room for the end of the blank line was checked with its beginning */
+				if (blank && blank_logged && print_text) {
+					uint32_t cycle_time = vfd_scan_period;
+					serial_print(" %u cycles (%u,%u ms)\n", line->scan_time,
+								 (unsigned)((line->scan_time * cycle_time) / 1000),
+								 (unsigned)((line->scan_time * cycle_time) % 1000));
 				}
-				if (app_flags & APP_PRINT_ENABLE) {
+				/* scan lines are dropped rather than wait for the serial port */
+				if (print_text && serial_log_begin(LOG_SCAN_MAX)) {
 					if (app_flags & APP_PRINT_HEX_SCAN) {
-						for (i = 0; i < NUM_SCAN_POS; i++)
-							serial_print("%02X ", vfd[line].scan_buf[i]);
+						for (i = 0; i < NUM_SCAN_POS; i++) {
+							serial_puth(line->scan_buf[i]);
+							serial_putc(' ');
+						}
+					}
+					/* update text of changed positions only */
+					for (uint16_t bits = text_pending; bits; bits &= bits - 1) {
+						i = __builtin_ctz(bits);
+						scan_to_text(seg_text[i], line->scan_buf[i]);
 					}
+					text_pending = 0;
 					serial_putc('\'');
 					for (i = 0; i < NUM_SCAN_POS; i++) {
-						uint8_t scan = vfd[line].scan_buf[i];
-						uint8_t sym = seg_map[scan & 0x7F];
-						if (sym) {
-							sym = seg_sym[sym];
-							serial_putc(sym);
-							if (scan & SEG_DOT)
-								serial_putc('.');
-							if (i == (NUM_DIGITS - 1))
-								serial_puts("' ["); /* print virtual digits in brackets */
-						} else
-							serial_print("(%02X)", scan);
+						serial_puts(seg_text[i]);
+						if (i == (NUM_DIGITS - 1))
+							serial_puts("' ["); /* print virtual digits in brackets */
 					}
-					serial_print("]");
+					serial_putc(']');
 					if (line_type & LINE_TYPE_EXEC)
 						serial_puts(" RUNNIG");
+					if (skipped) {
+						serial_puts(" (");
+						serial_putu(skipped);
+						serial_puts(" skipped)");
+					}
 					serial_putc('\n');
+					serial_log_end();
 				}
 				blank = false;
 			} else if (line_type & LINE_TYPE_IDLE) {
-#if OLED_OUTPUT_ENABLED
-				/**
-				 * if a program is running then do not turn oled off,
-				 * instead, clear it and flush to animate the execution
-				 */
-				if (line_type & LINE_TYPE_EXEC) {
-					oled_clear_frame(OLED_COLOR_BLACK);
-					oled_flush_frame();
-				} else
-					sh1122_set_oled_on(false);
-#endif
-				if (app_flags & APP_PRINT_ENABLE)
+				blank_logged = print_text && serial_log_begin(LOG_BLANK_LEN + LOG_CYCLES_MAX);
+				if (blank_logged) {
 					serial_puts("'             '");
+					serial_log_end();
+				}
 				blank = true;
 			}
+			scanq_release(&vfd_queue);
 		}
+#if OLED_OUTPUT_ENABLED
+		render_jobs();
+#if OLED_INFO_LINE
+		info_poll();
+#endif
+		/**
+		 * send changes, if the previous flush is still in progress or the flush rate
+		 * limit is reached then they are coalesced and sent later
+		 */
+		oled_flush_poll();
+#endif
+		uint32_t loop_clocks = DWT->CYCCNT - loop_start;
+		if (loop_clocks > app_loop_max)
+			app_loop_max = loop_clocks;
 	}
 }
 
 /**
  * Display scanner is implemented two interrupts:
- * 1. Interrupt on the rising edge of the pin wired to digit 8 grid control signal
- * 2. Timer 4 interupt
+ * 1. Interrupt on the rising edge of the pin wired to digit 8 grid control signal:
+ *    TIM3 input capture if SCAN_START_CAPTURE is set, EXTI otherwise
+ * 2. Timer 4 interupt, or DMA transfer complete interrupt if SCAN_USE_DMA is set
+ *
+ * First interrupt starts a new cycle of the phase-locked scheduler and TIM4 counter.
+ * TIM4 interrupts 14 times and scans corresponding digit segments in the middle
+ * of every grid window. The last interrupt of this cycle will check if any changes
+ * detected and will send notification event to the main loop
+ *
+ * With SCAN_USE_DMA TIM4 update events trigger DMA1 channel 7 to copy
+ * segments port to scan_dma[], so only one interrupt is taken per cycle
+ * when the transfer is complete.
+ * If vfd_oversample > 1 then every grid window is sampled that many times
+ * and segments are restored by per-bit majority vote.
  *
- * First interrupt reads segments of the digit 8 and then start TIM4 counter.
- * TIM4 interrupts 13 times and scans corresponding digit segments.
- * The last interrupt of this cycle will check if any changes detected and
- * will send notification event to the main loop
+ * TIM3 and TIM4 run without prescaler, so DWT->CYCCNT and timers count sys clocks.
+ * With the input capture the edge timestamp is taken by hardware, so interrupt
+ * entry jitter does not move sampling points.
  */
-uint32_t scan_ts; 				/* scan start timestamp */
 volatile uint32_t vfd_scan_period; 	/* interval between scan pin interrupts, in usec */
-volatile uint32_t vfd_curr_arr; /* timer auto reload register for current scan period */
-volatile uint32_t vfd_tim_arr;	/* timer auto reload register modified by timer */
+volatile uint32_t vfd_curr_arr; /* grid window for current scan period, in usec */
 volatile uint32_t vfd_wd;		/* watchdog timer, scan interrupt resets to 0 */
-static scan_t   raw;	   		/* buffer to store single scan data */
-static uint8_t  digit_idx; 		/* index of a digit being scanned, 0 - scan pin interrupt */
-static uint8_t  scan_line; 		/* index of the scan buffer entry */
-static uint16_t raw_new;   		/* mask of values changed from the last scan */
-static uint16_t raw_valid; 		/* mask of digits with at least one segment on */
-
-/* mapping to convert our scanning indexes to digits' indexes */
-static const uint8_t digits_map[NUM_SCAN_POS] = {8, 7, 6, 5, 4, 3, 2, 1, 0, 11, 10, 9, 12, 13};
+volatile uint32_t vfd_isr_clocks; /* clocks spent in scanner interrupts during the last cycle */
+vfd_pll_t vfd_pll;				/* phase-locked scan scheduler */
+static uint32_t   isr_clocks;	/* clocks spent in scanner interrupts during the current cycle */
+static uint32_t   sample_target; /* scheduled timestamp of the next sample */
+static vfd_scan_t scan;	   		/* single scan data and change masks */
+static uint8_t  digit_idx; 		/* index of a digit being scanned */
+#if SCAN_USE_DMA
+static uint8_t  scan_dma[NUM_SCAN_POS * VFD_VOTE_MAX]; /* segments captured in scanning order */
+static uint8_t  scan_n;			/* number of samples per digit for the current cycle */
+static uint32_t sample_sched;	/* timestamp of the last sample by the TIM4 step, see vfd_pll_step() */
+#endif
+volatile uint8_t  vfd_oversample = 1; /* number of samples per digit, odd, 1 to VFD_VOTE_MAX, DMA only */
+volatile uint32_t vfd_vote_bits;  /* number of segment bits corrected by majority vote */
+volatile uint32_t vfd_vote_scans; /* number of scan cycles with corrected bits */
 
 static inline void read_segments(uint8_t idx) {
 	uint16_t reg = SEG_GPIO_Port->IDR;
-	uint16_t seg = reg & SEG_PINS;
-	if (seg)
-		raw_valid |= 1 << idx;
-	if (raw.scan_buf[idx] != seg)
-		raw_new |= 1 << idx;
-	raw.scan_buf[idx] = seg;
+	vfd_scan_store(&scan, idx, reg & SEG_PINS);
+}
+
+/* convert delay in sys clocks to TIM4 auto reload value */
+static inline uint32_t delay_to_arr(uint32_t delay) {
+	if (delay < 2)
+		return 1;
+	if (delay > 0x10000)
+		return 0xFFFF;
+	return delay - 1;
+}
+
+/* post the completed scan cycle line, called from the last scanner interrupt */
+static inline void post_scan(void)
+{
+	if (!vfd_scan_finish(&scan, app_flags & APP_PRINT_KEY_SCAN))
+		return;
+	if (vfd_scan_is_spare(&scan))
+		vfd_queue.overruns++; /* main loop is too slow */
+	else {
+		scan.line->stamp = DWT->CYCCNT;
+		scanq_commit(&vfd_queue);
+	}
 }
 
 /**
-  * @brief  EXTI line detection callbacks.
-  * @param  GPIO_Pin: Specifies the pins connected EXTI line
-  * @retval None
-  */
-void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
+ * start a new scan cycle
+ * @param edge: timestamp of the scan pin rising edge
+ * @param ts: timestamp of the interrupt entry, for ISR load accounting
+ */
+static void scan_cycle_start(uint32_t edge, uint32_t ts)
 {
 	led_on(); /* pulse for oscilloscope for execution teracking */
 
 	vfd_wd = 0; /* reset watchdog timer */
-	/* the first call of the interrupt, store the current system clock counter */
-	if (scan_ts == 0) {
-		scan_ts = DWT->CYCCNT;
+	/* ignore the first edge and any very short intervals: MK52 is starting up */
+	if (!vfd_pll_start(&vfd_pll, edge))
 		goto exit;
-	}
-
-	vfd_scan_period = DWT->CYCCNT - scan_ts;
-	scan_ts = DWT->CYCCNT;
-	vfd_scan_period /= clocks_per_usec;
-	if (vfd_scan_period < 1000) /* ignore any very short intervals: MK52 is starting up */
-		goto exit;
-	/* re-calculate and update scanning timer period */
-	vfd_curr_arr = vfd_tim_arr = vfd_scan_period / NUM_SCAN_POS;
-	tim_set_arr(TIM4, vfd_tim_arr + 2); /* 2 usec extra delay for the first tim interrupt */
 
-	delay_usec(SCAN_START_DELAY); /* small delay for segments' signals to stabilize */
+	vfd_scan_period = (vfd_pll.period >> VFD_PLL_FRAC) / clocks_per_usec;
+	vfd_curr_arr = vfd_scan_period / NUM_SCAN_POS;
 	/* reset counter for a new scan cycle */
 	digit_idx = 0;
-	raw_new = raw_valid = 0;
-	read_segments(digits_map[digit_idx++]);
+	/* scan directly to the queue slot */
+	vfd_scan_start(&scan, scanq_reserve(&vfd_queue));
+#if SCAN_USE_DMA
+	scan_n = vfd_oversample;
+	/**
+	 * TIM4 runs freely: the first update at the first sampling point,
+	 * the next ones are preloaded to follow every window / n clocks
+	 */
+	uint32_t step = vfd_pll_step(&vfd_pll, scan_n, &sample_sched);
+	tim_set_arr(TIM4, delay_to_arr(vfd_pll_delay(&vfd_pll, sample_sched, DWT->CYCCNT)));
+	TIM4->ARR = delay_to_arr(step);
+	dma_scan_start(scan_dma, NUM_SCAN_POS * scan_n);
+	tim_dma_enable(TIM4); /* start our scanning timer */
+	/* the last sample is checked by the transfer complete interrupt */
+	sample_sched += (NUM_SCAN_POS * scan_n - 1) * step;
+	sample_target = vfd_pll_target(&vfd_pll, NUM_SCAN_POS - 1, scan_n - 1, scan_n);
+#else
+	sample_target = vfd_pll_target(&vfd_pll, 0, 0, 1);
+	tim_set_arr(TIM4, delay_to_arr(vfd_pll_delay(&vfd_pll, sample_target, DWT->CYCCNT)));
 	tim_enable(TIM4); /* start our scanning timer */
+#endif
 exit:
 	led_off();
-	/* ~5.4 us if SCAN_START_DELAY is 2us */
+	isr_clocks = DWT->CYCCNT - ts;
 }
 
+#if SCAN_START_CAPTURE
+/**
+ * scan pin rising edge captured by TIM3 channel 3
+ */
+void TIM3_IRQHandler(void)
+{
+	uint32_t ts = DWT->CYCCNT;
+	uint16_t cnt = TIM3->CNT;
+	uint16_t ccr = TIM3->CCR3; /* reading CCR3 clears TIM_SR_CC3IF */
+	TIM3->SR = (uint16_t)~TIM_SR_CC3OF; /* rc_w0 flags, write 1 to keep others */
+	/* TIM3 wraps every 65536 clocks, much longer than the interrupt latency */
+	scan_cycle_start(ts - (uint16_t)(cnt - ccr), ts);
+}
+#else
+/**
+  * @brief  EXTI line detection callbacks.
+  * @param  GPIO_Pin: Specifies the pins connected EXTI line
+  * @retval None
+  */
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
+{
+	uint32_t ts = DWT->CYCCNT;
+	scan_cycle_start(ts, ts);
+}
+#endif
+
+#if SCAN_USE_DMA
+/**
+ * all segments are captured, post-process the whole scan cycle
+ */
+void DMA1_Channel7_IRQHandler(void)
+{
+	/* TIM4 counts down from ARR since the update which took the last sample */
+	uint16_t since = TIM4->ARR - TIM4->CNT;
+	uint32_t ts = DWT->CYCCNT;
+	dbg_low();
+	tim_dma_disable(TIM4);
+	dma_scan_stop();
+	/**
+	 * phase of the last sample to stats, the latency of the first sample delay
+	 * is learned without the rounding of the TIM4 step, it is the same every cycle
+	 */
+	int32_t err = vfd_pll_error(&vfd_pll, sample_target, ts - since);
+	vfd_pll_learn(&vfd_pll, err - (int32_t)(sample_sched - sample_target));
+
+	if (scan_n > 1) {
+		uint8_t votes[NUM_SCAN_POS];
+		uint16_t corrected = vfd_vote_cycle(scan_dma, scan_n, votes);
+		if (corrected) {
+			vfd_vote_bits += corrected;
+			vfd_vote_scans++;
+		}
+		vfd_scan_store_all(&scan, votes);
+	} else
+		vfd_scan_store_all(&scan, scan_dma);
+	post_scan();
+
+	dbg_high();
+	vfd_isr_clocks = isr_clocks + (DWT->CYCCNT - ts);
+}
+#else
 /**
  * use our own timer IRQ handler as we do not need all extra HAL stuff
  * for our simple timer configuration
  */
 void TIM4_IRQHandler(void)
 {
-	static uint8_t is_running; /** true if program execution in progress */
+	uint32_t ts = DWT->CYCCNT;
 	dbg_low();
 	read_segments(digits_map[digit_idx++]);
+	/* adjust scheduler latency, so IRQ handler code execution is compensated */
+	vfd_pll_sample(&vfd_pll, sample_target, ts);
 
 	if (digit_idx == NUM_SCAN_POS) { /* last scan interrupt */
 		tim_disable(TIM4);
-
-		if (!(app_flags & APP_PRINT_KEY_SCAN)) {
-			/* ignore virtual digits to avoid false positive events */
-			raw_new &= 0x0FFF;
-			raw_valid &= 0x0FFF;
-		}
-
-		/* at list one real digit had changed */
-		if (raw_new && raw_valid) {
-			is_running = (raw.key[0] == PROGRAM_RUNNING) ? LINE_TYPE_EXEC : 0;
-			raw.scan_buf[0] &= SEG_G; /* only '-' is valid for the first position */
-			memcpy(&vfd[scan_line], &raw, sizeof(scan_t));
-			scan_line |= LINE_TYPE_NORMAL | is_running;
-			rbuf_write(&evbuf, scan_line);
-			scan_line = (scan_line + 1) & (NUM_LINES - 1);
-			raw.scan_time = 0;
-		} else if (!raw_valid) { /* all digits are blank */
-			if (!raw.scan_time)	 /* first invalid scan */
-				rbuf_write(&evbuf, LINE_TYPE_IDLE | is_running);
-			raw.scan_time += 1;
-		}
+		TIM4->SR &= ~TIM_SR_UIF;
+		post_scan();
+	} else {
+		sample_target = vfd_pll_target(&vfd_pll, digit_idx, 0, 1);
+		/** tim_set_arr() resets interrupt flag for us,
+		 * no need to reset it here
+		TIM4->SR &= ~TIM_SR_UIF;
+		*/
+		tim_set_arr(TIM4, delay_to_arr(vfd_pll_delay(&vfd_pll, sample_target, DWT->CYCCNT)));
 	}
-	/**
-	 * a small compensation for IRQ handler code execution
-	 * '0x03' value had been handpicked using an oscilloscope
-	 * */
-	if ((digit_idx & 0x03) == 0x03)
-		vfd_tim_arr -= 2;
-	tim_set_arr(TIM4, vfd_tim_arr);
-
-	/** tim_set_arr() resets interrupt flag for us,
-	 * no need to reset it here
-	TIM4->SR &= ~TIM_SR_UIF;
-	*/
+
 	dbg_high();
-	/* ~1.0us for normal scan */
-	/* ~2.5us for the last scan */
+	isr_clocks += DWT->CYCCNT - ts;
+	if (digit_idx == NUM_SCAN_POS)
+		vfd_isr_clocks = isr_clocks;
+}
+#endif
+
+/**
+ * OLED SPI DMA transfer complete, send the next window of the frame flush
+ */
+void DMA1_Channel5_IRQHandler(void)
+{
+	oled_flush_isr();
 }
@@ -0,0 +1,108 @@
+/**
+ * Terminal input decoder: arrow and editing keys escape sequences
+ * to key codes, CR and CR+LF to LF.
+ *
+ * Bytes are decoded one by one, so a sequence split between bursts
+ * of received bytes is decoded the same way as a whole one.
+ * Does not depend on HAL or any STM32 peripherals, so it can be built
+ * for a host.
+ *
+ * MIT License
+ */
+#ifndef MK52_ESCAPE_SEQUENCE_H
+#define MK52_ESCAPE_SEQUENCE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** non-character flag */
+#define EXTRA_KEY   0x0100
+
+/** support for arrow keys for very simple one command deep history */
+#define ARROW_UP    0x0141
+#define ARROW_DOWN  0x0142
+#define ARROW_RIGHT 0x0143
+#define ARROW_LEFT  0x0144
+
+#define KEY_HOME    0x0101
+#define KEY_INS	    0x0102
+#define KEY_DEL	    0x0103
+#define KEY_END	    0x0104
+#define KEY_PGUP    0x0105
+#define KEY_PGDN    0x0106
+
+/* Escape sequence states */
+#define ESC_CHAR    0
+#define ESC_BRACKET 1
+#define ESC_BRCHAR  2
+#define ESC_TILDA   3
+#define ESC_CRLF    5
+
+typedef struct esc_seq_s {
+	uint8_t state; /** ESC_* state */
+	uint8_t idx;   /** key index of ESC [ n ~ sequence */
+} esc_seq_t;
+
+/**
+ * decode the next received byte
+ * @return character, EXTRA_KEY code, or 0 if nothing is decoded yet
+ */
+static inline uint16_t esc_seq_decode(esc_seq_t *esc, uint8_t byte)
+{
+	uint16_t ch = byte;
+
+	if (ch == 27) {
+		esc->state = ESC_BRACKET;
+		return 0;
+	}
+	if (esc->state == ESC_BRACKET) {
+		if (ch == '[') {
+			esc->state = ESC_BRCHAR;
+			return 0;
+		}
+	}
+	if (esc->state == ESC_BRCHAR) {
+		esc->state = ESC_CHAR;
+		if (ch >= 'A' && ch <= 'D') {
+			ch |= EXTRA_KEY;
+			return ch;
+		}
+		if ((ch >= '1') && (ch <= '6')) {
+			esc->state = ESC_TILDA;
+			esc->idx = ch - '0';
+			return 0;
+		}
+		return ch;
+	}
+	if (esc->state == ESC_TILDA) {
+		esc->state = ESC_CHAR;
+		if (ch == '~') {
+			ch = EXTRA_KEY | esc->idx;
+			return ch;
+		}
+		return 0;
+	}
+
+	/* convert CR to LF */
+	if (ch == '\r') {
+		esc->state = ESC_CRLF;
+		return '\n';
+	}
+	/* do not return LF if it is part of CR+LF combination */
+	if (ch == '\n') {
+		if (esc->state == ESC_CRLF) {
+			esc->state = ESC_CHAR;
+			return 0;
+		}
+	}
+	esc->state = ESC_CHAR;
+	return ch;
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -4,17 +4,102 @@
 #include <string.h>
 
 #include "oled.h"
+#include "dma.h"
+#include "raster.h"
 
 #define USE_HAL_SPI 0
 
 uint8_t oled_rotated;
 uint32_t font_color;
 
+/**
+ * brightness engine: symbols are drawn with the same font color,
+ * brightness, program running dimming and blanking are set by SH1122 commands
+ */
+static uint8_t oled_contrast = OLED_DEFAULT_CONTRAST; /* user contrast */
+static bool oled_dimmed;       /* true to dim the display while a program is running */
+static bool oled_blanked;      /* true to blank the display, the frame is kept */
+static uint8_t contrast_sent;  /* the last contrast sent to SH1122 */
+static bool blank_sent;        /* the last blanking sent to SH1122 */
+static bool display_pending;   /* commands to be sent when the flush in progress is done */
+static uint8_t indicator;      /* color of the running indicator, both nibbles, 0 if not shown */
+static uint32_t render_clocks; /* sys clocks spent drawing symbols, see oled_stats_t */
+static void apply_display(void);
+
+/**
+ * dirty regions of the frame, in bytes (two pixels) and rows,
+ * x1 and y1 are exclusive
+ */
+typedef struct oled_rect_s {
+	uint8_t x0, x1;
+	uint8_t y0, y1;
+} oled_rect_t;
+
 /* buffer of symbols being displayed */
 static uint8_t oled_sym[OLED_DIGITS];
+/* mask of positions to be printed again after the frame clear or font color change */
+static uint16_t sym_stale;
+
+#if OLED_INFO_LINE
+static uint8_t info_sym[OLED_DIGITS]; /* segments of the info line being displayed */
+static bool info_stale;               /* true to print the whole info line again */
+static uint32_t info_clocks;          /* sys clocks spent drawing the info line, see oled_stats_t */
+static oled_cell_t info_cells[OLED_DIGITS]; /* cells of the info line, as oled_cells */
+#endif
+
+static uint8_t oled_bkg; /* background color, both nibbles */
 
-/** OLED frame buffer */
-uint8_t oled_frame[OLED_LINE_SIZE * OLED_FONT_HEIGHT];
+/* symbol cells of the frame, expanded to pixels line by line when sent */
+static oled_cell_t oled_cells[OLED_DIGITS];
+/* ping-pong line buffers: one is sent by DMA while the next line is expanded to another */
+static uint8_t line_buf[2][OLED_LINE_SIZE] __attribute__((aligned(4)));
+static void expand_line(uint8_t *buf, uint8_t y, const oled_rect_t *rect);
+
+/** statistics of the last frame flush */
+oled_stats_t oled_stats;
+oled_load_t oled_load;
+
+/* flush rate limit, see oled_flush_poll() */
+static uint16_t flush_rate = OLED_FLUSH_RATE;
+static uint32_t flush_period; /* sys clocks, 0 for no limit */
+static uint32_t flush_last;   /* DWT timestamp of the last flush start */
+
+
+#define OLED_DIRTY_MAX 8 /* max number of separately flushed regions */
+/**
+ * cost of a window in bytes: column and row commands plus CS and DC toggling,
+ * used to decide if two regions should be flushed as one
+ */
+#define OLED_WINDOW_COST 8
+
+static oled_rect_t dirty[OLED_DIRTY_MAX];
+static uint8_t dirty_num;
+static uint32_t dirty_stamp; /* DWT timestamp of the first dirty region */
+
+
+/* true to send data and commands using 16 bit SPI frames */
+static bool spi16 = OLED_SPI16;
+/* true to drive only the frame rows, see OLED_GLYPH_ROWS */
+static bool glyph_rows = OLED_GLYPH_ROWS;
+
+/* flush in progress */
+static struct {
+	oled_rect_t rect[OLED_DIRTY_MAX]; /* regions to send */
+	uint8_t num;   /* number of regions */
+	uint8_t idx;   /* region being sent */
+	uint8_t y;     /* the next row of the region to send */
+	uint16_t fill; /* RAM clear color, DMA source */
+	uint32_t start; /* DWT timestamp of the flush start */
+	uint32_t stamp; /* DWT timestamp of the first dirty region of the flush */
+	oled_cell_t cell[OLED_DIGITS]; /* snapshot of the cells being sent */
+	uint8_t bkg;   /* snapshot of the background color */
+	uint8_t indicator; /* snapshot of the running indicator color */
+#if OLED_INFO_LINE
+	oled_cell_t info[OLED_DIGITS]; /* snapshot of the info line cells */
+#endif
+	uint8_t lb;    /* line buffer with the next line to send */
+	volatile bool busy;
+} tx;
 
 static void spi_send_byte(uint8_t data)
 {
@@ -26,12 +111,46 @@ static void spi_send_byte(uint8_t data)
 #endif
 }
 
+/* 16 bit SPI frame, MSB first, so 'data' high byte is sent first */
+static void spi_send_word(uint16_t data)
+{
+	while(!(spi->SR & SPI_SR_TXE));
+	spi->DR = data;
+}
+
+/* switch SPI data frame size, SPI must be idle */
+static void spi_set_frame16(bool on)
+{
+	spi->CR1 &= ~SPI_CR1_SPE;
+	if (on)
+		spi->CR1 |= SPI_CR1_DFF;
+	else
+		spi->CR1 &= ~SPI_CR1_DFF;
+	spi->CR1 |= SPI_CR1_SPE;
+}
+
+void oled_set_spi16(bool on)
+{
+	oled_flush_wait();
+	spi16 = on;
+	spi_set_frame16(on);
+}
+
+bool oled_is_spi16(void)
+{
+	return spi16;
+}
+
 /* send single-byte command to SH1122 */
 void oled_send_cmd(uint8_t cmd)
 {
+	oled_flush_wait();
 	oled_cs_select();
 	oled_dc_cmd();
-	spi_send_byte(cmd);
+	if (spi16)
+		spi_send_word((cmd << 8) | SH1122_CMD_NOP);
+	else
+		spi_send_byte(cmd);
 	while(spi->SR & SPI_SR_BSY); /* make sure that command is sent before unselecting */
 	oled_cs_unselect();
 }
@@ -39,22 +158,329 @@ void oled_send_cmd(uint8_t cmd)
 /* send double-byte command to SH1122 */
 void oled_send_cmd_arg(uint8_t cmd, uint8_t arg)
 {
+	oled_flush_wait();
 	oled_cs_select();
 	oled_dc_cmd();
-	spi_send_byte(cmd);
-    spi_send_byte(arg);
+	if (spi16)
+		spi_send_word((cmd << 8) | arg);
+	else {
+		spi_send_byte(cmd);
+		spi_send_byte(arg);
+	}
 	while(spi->SR & SPI_SR_BSY); /* make sure that command is sent before unselecting */
 	oled_cs_unselect();
 }
 
 void oled_send_data(uint8_t *data, uint16_t len)
 {
+	oled_flush_wait();
+	if (spi16 && (len & 0x01))
+		spi_set_frame16(false); /* odd number of bytes, use 8 bit frames for this transfer */
 	oled_cs_select();
 	oled_dc_data();
-	for (uint16_t i = 0; i < len; i ++)
-		spi_send_byte(data[i]);
+	if (spi16 && !(len & 0x01)) {
+		for (uint16_t i = 0; i < len; i += 2)
+			spi_send_word((data[i] << 8) | data[i + 1]);
+	} else {
+		for (uint16_t i = 0; i < len; i ++)
+			spi_send_byte(data[i]);
+	}
 	while(spi->SR & SPI_SR_BSY); /* make sure that data is sent before unselecting */
 	oled_cs_unselect();
+	if (spi16 && (len & 0x01))
+		spi_set_frame16(true);
+}
+
+/**
+ * send multi-byte command sequence to SH1122 in one transfer, used by the flush itself
+ * @param len: even number of bytes
+ */
+static void oled_send_cmds(const uint8_t *cmd, uint8_t len)
+{
+	oled_cs_select();
+	oled_dc_cmd();
+	if (spi16) {
+		for (uint8_t i = 0; i < len; i += 2)
+			spi_send_word((cmd[i] << 8) | cmd[i + 1]);
+	} else {
+		for (uint8_t i = 0; i < len; i++)
+			spi_send_byte(cmd[i]);
+	}
+	while(spi->SR & SPI_SR_BSY); /* make sure that command is sent before unselecting */
+	oled_cs_unselect();
+}
+
+/* set column and row addresses of the frame position in the OLED RAM */
+/* RAM row of a frame row, with all rows driven the rotated frame is moved by a half of RAM */
+static inline uint8_t ram_row(uint8_t y)
+{
+	if (glyph_rows)
+		return y;
+	return (y + 32 * oled_rotated) & 0x3F;
+}
+
+static void oled_set_window(uint8_t x, uint8_t y)
+{
+	const uint8_t cmd[4] = {
+		SH1122_CMD_SET_COL_LOW | (x & 0x0F), SH1122_CMD_SET_COL_HIGH | ((x >> 4) & 0x07),
+		SH1122_CMD_SET_ROW, ram_row(y)
+	};
+	oled_send_cmds(cmd, sizeof(cmd));
+}
+
+/* number of bytes to send to flush the region */
+static uint32_t rect_cost(const oled_rect_t *rect)
+{
+	uint32_t rows = rect->y1 - rect->y0;
+	uint32_t width = rect->x1 - rect->x0;
+	if (width == OLED_LINE_SIZE) /* full lines are sent in one go */
+		return rows * width + OLED_WINDOW_COST;
+	return rows * (width + OLED_WINDOW_COST);
+}
+
+static void rect_merge(oled_rect_t *dst, const oled_rect_t *src)
+{
+	if (src->x0 < dst->x0) dst->x0 = src->x0;
+	if (src->x1 > dst->x1) dst->x1 = src->x1;
+	if (src->y0 < dst->y0) dst->y0 = src->y0;
+	if (src->y1 > dst->y1) dst->y1 = src->y1;
+}
+
+#if OLED_INFO_LINE
+/* 1 for a region of the digits rows, 2 for the info line rows, 3 for both */
+static inline uint8_t rect_band(const oled_rect_t *rect)
+{
+	return (rect->y0 < OLED_INFO_ROW) | ((rect->y1 > OLED_INFO_ROW) << 1);
+}
+#endif
+
+/* extra cost of flushing two regions as one */
+static int32_t rect_merge_cost(const oled_rect_t *a, const oled_rect_t *b)
+{
+#if OLED_INFO_LINE
+	/* the info line is flushed separately, so its changes never send the digits again */
+	if ((rect_band(a) | rect_band(b)) == 3 && rect_band(a) != 3 && rect_band(b) != 3)
+		return INT32_MAX;
+#endif
+	oled_rect_t box = *a;
+	rect_merge(&box, b);
+	return (int32_t)rect_cost(&box) - (int32_t)(rect_cost(a) + rect_cost(b));
+}
+
+void oled_mark_dirty(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1)
+{
+	if (x1 > OLED_LINE_SIZE)
+		x1 = OLED_LINE_SIZE;
+	if (y1 > OLED_FRAME_HEIGHT)
+		y1 = OLED_FRAME_HEIGHT;
+	if (x0 >= x1 || y0 >= y1)
+		return;
+	if (!dirty_num)
+		dirty_stamp = DWT->CYCCNT;
+	/* regions are aligned to two bytes for 16 bit SPI transfers */
+	x0 &= ~0x01;
+	x1 = (x1 + 1) & ~0x01;
+
+	oled_rect_t rect = { x0, x1, y0, y1 };
+	/* merge with existing regions while it is cheaper than sending them separately */
+	for (uint8_t i = 0; i < dirty_num;) {
+		if (rect_merge_cost(&dirty[i], &rect) <= 0) {
+			rect_merge(&rect, &dirty[i]);
+			dirty[i] = dirty[--dirty_num];
+			i = 0;
+			continue;
+		}
+		i++;
+	}
+
+	if (dirty_num == OLED_DIRTY_MAX) {
+		/* no free slots, merge with the region which costs less */
+		uint8_t best = 0;
+		int32_t best_cost = INT32_MAX;
+		for (uint8_t i = 0; i < dirty_num; i++) {
+			int32_t cost = rect_merge_cost(&dirty[i], &rect);
+			if (cost < best_cost) {
+				best_cost = cost;
+				best = i;
+			}
+		}
+		rect_merge(&dirty[best], &rect);
+		return;
+	}
+	dirty[dirty_num++] = rect;
+}
+
+/* start sending the next window of the flush in progress, or complete the flush */
+static void flush_next(void)
+{
+	if (tx.idx == tx.num) {
+		if (tx.num) {
+			oled_stats.clocks = DWT->CYCCNT - tx.start;
+			oled_stats.render_clocks = render_clocks;
+#if OLED_INFO_LINE
+			oled_stats.info_clocks = info_clocks;
+#endif
+			uint32_t latency = DWT->CYCCNT - tx.stamp;
+			if (latency > oled_load.lat_max)
+				oled_load.lat_max = latency;
+			oled_load.lat_sum += latency;
+			oled_load.flushes++;
+			oled_load.spi_clocks += oled_stats.clocks;
+			oled_load.cpu_clocks += oled_stats.copy_clocks + oled_stats.render_clocks;
+			oled_load.bytes += oled_stats.bytes;
+			oled_load.info_bytes += oled_stats.info_bytes;
+			oled_load.info_clocks += oled_stats.info_clocks;
+		}
+		tx.busy = false;
+		oled_flush_callback();
+		return;
+	}
+
+	oled_rect_t *rect = &tx.rect[tx.idx];
+	uint8_t y = tx.y;
+	uint16_t len = rect->x1 - rect->x0;
+	/* lines are expanded one by one, full lines continue where the previous one ended */
+	bool window = (len != OLED_LINE_SIZE) || (y == rect->y0);
+	const uint8_t *data = &line_buf[tx.lb][rect->x0];
+	tx.y++;
+	if (tx.y == rect->y1 && ++tx.idx < tx.num)
+		tx.y = tx.rect[tx.idx].y0;
+
+	if (window)
+		oled_set_window(rect->x0, y);
+	oled_cs_select();
+	oled_dc_data();
+	if (spi16)
+		len /= 2;
+	dma_spi_tx_start(spi, data, len, true, spi16);
+	/* prepare the next line while this one is sent */
+	tx.lb ^= 1;
+	if (tx.idx < tx.num)
+		expand_line(line_buf[tx.lb], tx.y, &tx.rect[tx.idx]);
+}
+
+void oled_flush_isr(void)
+{
+	dma_spi_tx_stop(spi);
+	/* DMA is done when the last byte is written to SPI, wait until it is shifted out */
+	while(!(spi->SR & SPI_SR_TXE));
+	while(spi->SR & SPI_SR_BSY);
+	oled_cs_unselect();
+	flush_next();
+}
+
+__weak void oled_flush_callback(void)
+{
+}
+
+bool oled_flush_start(void)
+{
+	uint32_t bytes = 0;
+
+	if (tx.busy)
+		return false;
+	if (display_pending)
+		apply_display();
+	if (!dirty_num)
+		return false;
+
+	tx.start = DWT->CYCCNT;
+	tx.stamp = dirty_stamp;
+	for (uint8_t i = 0; i < dirty_num; i++)
+		bytes += rect_cost(&dirty[i]);
+
+	if (bytes >= OLED_LINE_SIZE * OLED_FRAME_HEIGHT + OLED_WINDOW_COST) {
+		/* cheaper to send the whole frame */
+		dirty[0] = (oled_rect_t){ 0, OLED_LINE_SIZE, 0, OLED_FRAME_HEIGHT };
+		dirty_num = 1;
+	}
+
+	/* take a snapshot of the dirty regions, so the next frame can be rendered while this one is sent */
+	bytes = 0;
+	memcpy(tx.cell, oled_cells, sizeof(tx.cell));
+	tx.bkg = oled_bkg;
+	tx.indicator = indicator;
+#if OLED_INFO_LINE
+	memcpy(tx.info, info_cells, sizeof(tx.info));
+#endif
+	oled_stats.info_bytes = 0;
+	for (uint8_t i = 0; i < dirty_num; i++) {
+		oled_rect_t *rect = &dirty[i];
+		uint8_t width = rect->x1 - rect->x0;
+		bytes += (rect->y1 - rect->y0) * width;
+#if OLED_INFO_LINE
+		if (rect->y1 > OLED_INFO_ROW)
+			oled_stats.info_bytes += (rect->y1 - (rect->y0 > OLED_INFO_ROW ? rect->y0 : OLED_INFO_ROW)) * width;
+#endif
+		tx.rect[i] = *rect;
+	}
+	tx.num = dirty_num;
+	tx.idx = 0;
+	tx.y = tx.rect[0].y0;
+	dirty_num = 0;
+	render_clocks = 0;
+#if OLED_INFO_LINE
+	info_clocks = 0;
+#endif
+	tx.lb = 0;
+	expand_line(line_buf[0], tx.y, &tx.rect[0]);
+	oled_stats.regions = tx.num;
+	oled_stats.bytes = bytes;
+	oled_stats.copy_clocks = DWT->CYCCNT - tx.start;
+
+	tx.busy = true;
+	/* the transfer complete interrupt must not run until the next line is prepared */
+	NVIC_DisableIRQ(OLED_DMA_IRQn);
+	flush_next();
+	NVIC_EnableIRQ(OLED_DMA_IRQn);
+	return true;
+}
+
+bool oled_flush_poll(void)
+{
+	if (flush_period && (DWT->CYCCNT - flush_last) < flush_period)
+		return false;
+	if (!oled_flush_start())
+		return false;
+	flush_last = tx.start;
+	return true;
+}
+
+void oled_set_flush_rate(uint16_t rate)
+{
+	flush_rate = rate;
+	flush_period = rate ? SystemCoreClock / rate : 0;
+}
+
+uint16_t oled_get_flush_rate(void)
+{
+	return flush_rate;
+}
+
+void oled_load_reset(void)
+{
+	/* flush completion updates the load from the interrupt */
+	NVIC_DisableIRQ(OLED_DMA_IRQn);
+	memset(&oled_load, 0, sizeof(oled_load));
+	oled_load.start = millis();
+	NVIC_EnableIRQ(OLED_DMA_IRQn);
+}
+
+bool oled_flush_busy(void)
+{
+	return tx.busy;
+}
+
+void oled_flush_wait(void)
+{
+	while(tx.busy);
+}
+
+void oled_flush_frame(void)
+{
+	oled_flush_wait();
+	if (oled_flush_start())
+		oled_flush_wait();
 }
 
 /** reset display */
@@ -76,39 +502,169 @@ void oled_set_font_color(uint8_t color)
 	uint32_t new_color = (color << 24) | (color << 16) | (color << 8) | color;
 	if (new_color != font_color) {
 		font_color = new_color;
-		/* force re-drawing of the frame buffer */
-		memset(oled_sym, SYM_MAX, sizeof(oled_sym));
+		/* force re-drawing of the frame */
+		oled_invalidate();
+	}
+}
+
+/* send contrast and display on/off commands if the resulting state had changed */
+static void apply_display(void)
+{
+	uint8_t contrast = oled_dimmed ? (oled_contrast >> OLED_DIM_SHIFT) : oled_contrast;
+#if OLED_BLANK_CONTRAST
+	if (oled_blanked)
+		contrast = 0;
+#endif
+	display_pending = false;
+	if (contrast != contrast_sent) {
+		contrast_sent = contrast;
+		sh1122_set_contrast(contrast);
+	}
+#if !OLED_BLANK_CONTRAST
+	if (oled_blanked != blank_sent) {
+		blank_sent = oled_blanked;
+		sh1122_set_oled_on(!oled_blanked);
+	}
+#endif
+}
+
+/* flush in progress owns SPI, so the commands are sent before the next flush */
+static void update_display(void)
+{
+	if (tx.busy)
+		display_pending = true;
+	else
+		apply_display();
+}
+
+void oled_set_contrast(uint8_t contrast)
+{
+	oled_contrast = contrast;
+	update_display();
+}
+
+uint8_t oled_get_contrast(void)
+{
+	return oled_contrast;
+}
+
+void oled_set_dimmed(bool dimmed)
+{
+	if (dimmed != oled_dimmed) {
+		oled_dimmed = dimmed;
+		update_display();
+	}
+}
+
+void oled_set_blanked(bool blanked)
+{
+	if (blanked != oled_blanked) {
+		oled_blanked = blanked;
+		update_display();
 	}
 }
 
+void oled_set_indicator(bool on)
+{
+	uint8_t color = on ? (uint8_t)font_color : 0;
+	if (color == indicator)
+		return;
+	indicator = color;
+	oled_mark_dirty(0, OLED_INDICATOR_LINE, (OLED_INDICATOR_WIDTH + 1) / OLED_PPB, OLED_FONT_HEIGHT);
+}
+
 void oled_clear_ram(uint8_t fill)
 {
-	/* clear SH1122 RAM */
+	/* clear driven rows of SH1122 RAM, the same byte is sent by DMA without source increment */
+	uint8_t rows = glyph_rows ? OLED_FRAME_HEIGHT : OLED_HEIGHT;
+	oled_flush_wait();
+	fill = (fill & 0x0F) | (fill << 4);
+	tx.fill = (fill << 8) | fill;
+	tx.num = tx.idx = 0;
+	oled_set_window(0, 0);
+	tx.busy = true;
 	oled_cs_select();
 	oled_dc_data();
-	fill = (fill & 0x0F) | (fill << 4);
-	for (uint16_t i = 0; i < OLED_WIDTH * OLED_HEIGHT / OLED_PPB; i++)
-		spi_send_byte(fill);
-	while(spi->SR & SPI_SR_BSY); /* make sure that data is sent before unselecting */
-	oled_cs_unselect();
+	dma_spi_tx_start(spi, (uint8_t *)&tx.fill, rows * OLED_LINE_SIZE / (1 + spi16), false, spi16);
+	/* RAM does not match the frame anymore */
+	oled_mark_dirty(0, 0, OLED_LINE_SIZE, OLED_FRAME_HEIGHT);
 	return;
 }
 
 void oled_clear_frame(uint8_t fill)
 {
 	fill = (fill & 0x0F) | (fill << 4);
-	memset(oled_frame, fill, sizeof(oled_frame));
-	memset(oled_sym, SYM_MAX, sizeof(oled_sym));
+	oled_bkg = fill;
+	indicator = 0;
+	for (uint8_t pos = 0; pos < OLED_DIGITS; pos++)
+		oled_cells[pos].sym = 0;
+#if OLED_INFO_LINE
+	memset(info_cells, 0, sizeof(info_cells));
+#endif
+	oled_invalidate();
+	oled_mark_dirty(0, 0, OLED_LINE_SIZE, OLED_FRAME_HEIGHT);
 	return;
 }
 
+void oled_invalidate(void)
+{
+	memset(oled_sym, SYM_MAX, sizeof(oled_sym));
+	sym_stale = (1u << OLED_DIGITS) - 1;
+#if OLED_INFO_LINE
+	info_stale = true;
+#endif
+}
+
+uint16_t oled_stale_mask(void)
+{
+	return sym_stale;
+}
+
+/* multiplex ratio, COM offset and the start line of the rows mode */
+static void apply_rows(void)
+{
+	if (glyph_rows) {
+		sh1122_set_multiplex_ration(OLED_FRAME_HEIGHT - 1);
+		sh1122_set_offset(OLED_ROWS_OFFSET);
+		sh1122_set_osc_mode(0, OLED_ROWS_OSC_FREQ);
+		sh1122_set_start_line(0);
+	} else {
+		sh1122_set_multiplex_ration(OLED_HEIGHT - 1);
+		sh1122_set_offset(0);
+		sh1122_set_osc_mode(0, SH1122_OSC_FREQ_POR);
+		sh1122_set_start_line(OLED_START_LINE);
+	}
+}
+
+void oled_set_glyph_rows(bool on)
+{
+	oled_flush_wait();
+	glyph_rows = on;
+	apply_rows();
+	/* the frame moves in RAM and rows not written for a while can be shown again */
+	oled_clear_ram(oled_bkg);
+}
+
+bool oled_is_glyph_rows(void)
+{
+	return glyph_rows;
+}
+
 void oled_init(uint8_t fill)
 {
+	oled_flush_wait();
+	oled_set_flush_rate(flush_rate);
+	oled_load_reset();
+	spi_set_frame16(spi16);
 	oled_reset();
 	sh1122_set_oled_on(false); /* oled off */
 	sh1122_set_dc_dc(SH1122_DC_DC_EXTERNAL, SH1122_DC_DC_FREQ_06SF);
 	oled_rotated = 0;
 	oled_set_font_color(OLED_DEFAULT_FONT_COLOR);
+	contrast_sent = SH1122_DEFAULT_CONTRAST; /* after the reset */
+	oled_blanked = blank_sent = false; /* turned on below */
+	apply_display();
+	apply_rows();
 	oled_clear_frame(fill);
 	oled_clear_ram(fill);
 	sh1122_set_oled_on(true);
@@ -120,853 +676,288 @@ void oled_rotate(bool rotated)
 {
 	sh1122_set_flip(rotated);
 	sh1122_set_remap(rotated ? SH1122_CMD_SET_DIR_REVERSE : SH1122_CMD_SET_DIR_NORMAL);
-	sh1122_set_row(rotated ? 32 : 0);
 	oled_rotated = !!rotated;
+	/* RAM is addressed differently, so the whole frame must be sent again */
+	oled_mark_dirty(0, 0, OLED_LINE_SIZE, OLED_FRAME_HEIGHT);
 }
 
-/** use specified color to draw a pixel at the given position */
-void oled_set_pixel(uint16_t x, uint16_t y, uint8_t color)
+uint32_t oled_frame_ram(void)
 {
-	if (y < OLED_FONT_HEIGHT) {
-		uint16_t pos = x / OLED_PPB + y * (OLED_WIDTH / OLED_PPB);
-		uint8_t data = oled_frame[pos];
-		if (x & 0x01)
-			data = (data & 0xF0) | color;
-		else
-			data = (data & 0x0F) | (color << 4);
-		oled_frame[pos] = data;
-	}
+	uint32_t ram = sizeof(oled_cells) + sizeof(oled_bkg) + sizeof(line_buf) + sizeof(tx.cell) + sizeof(tx.bkg) + sizeof(tx.indicator);
+#if OLED_INFO_LINE
+	ram += sizeof(info_cells) + sizeof(tx.info);
+#endif
+	return ram;
 }
 
-/** draw horizontal line */
-void oled_draw_line(uint8_t x, uint8_t y, uint16_t len, uint8_t color)
-{
-	for (uint16_t i = 0; i < len; i++)
-		oled_set_pixel(x + i, y, color);
-}
-
-/** draw vertical line */
-void oled_draw_row(uint8_t x, uint8_t y, uint8_t hight, uint8_t color)
-{
-	for (uint8_t i = 0; i < hight; i++)
-		oled_set_pixel(x, y + i, color);
-}
-
-/* symbols, supported by MK-52 */
-static const uint8_t digit_space[] = {
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   0  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   1  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   2  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   3  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   4  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   5  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   6  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   7  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   8  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   9  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  10  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  11  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  12  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  13  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  14  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  15  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  16  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /* <17> */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  18  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  19  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  20  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  21  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  22  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  23  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  24  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  25  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  26  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  27  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  28  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  29  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  30  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  31  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  32  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  33  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  34  */
-};
-
-static const uint8_t digit_minus[] = {
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   0  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   1  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   2  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   3  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   4  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   5  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   6  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   7  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   8  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   9  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  10  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  11  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  12  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  13  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  14  */
-	0x00, 0x00, 0x0F, 0xFF, 0xFF, 0xFF, 0xF0, 0x00, 0x00, 0x00, 0x00, /*  15  */
-	0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, /*  16  */
-	0x00, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0, 0x00, 0x00, 0x00, /* <17> */
-	0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, /*  18  */
-	0x00, 0x00, 0x0F, 0xFF, 0xFF, 0xFF, 0xF0, 0x00, 0x00, 0x00, 0x00, /*  19  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  20  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  21  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  22  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  23  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  24  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  25  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  26  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  27  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  28  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  29  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  30  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  31  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  32  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  33  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  34  */
-};
-
-static const uint8_t digit_0[] = {
-	0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, /*   0  */
-	0x00, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0, 0x00, 0x00, 0x00, /*   1  */
-	0x0F, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0xF0, 0x00, 0x00, /*   2  */
-	0xFF, 0xF0, 0x0F, 0xFF, 0xFF, 0xFF, 0xF0, 0x0F, 0xFF, 0x00, 0x00, /*   3  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   4  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   5  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   6  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   7  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   8  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   9  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  10  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  11  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  12  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  13  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  14  */
-	0xFF, 0xF0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0F, 0xFF, 0x00, 0x00, /*  15  */
-	0x0F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xF0, 0x00, 0x00, /*  16  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /* <17> */
-	0x0F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xF0, 0x00, 0x00, /*  18  */
-	0xFF, 0xF0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0F, 0xFF, 0x00, 0x00, /*  19  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  20  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  21  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  22  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  23  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  24  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  25  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  26  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  27  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  28  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  29  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  30  */
-	0xFF, 0xF0, 0x0F, 0xFF, 0xFF, 0xFF, 0xF0, 0x0F, 0xFF, 0x00, 0x00, /*  31  */
-	0x0F, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0xF0, 0x00, 0x00, /*  32  */
-	0x00, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0, 0x00, 0x00, 0x00, /*  33  */
-	0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, /*  34  */
-};
-
-static const uint8_t digit_1[] = {
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   0  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   1  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xF0, 0x00, 0x00, /*   2  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0F, 0xFF, 0x00, 0x00, /*   3  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   4  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   5  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   6  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   7  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   8  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   9  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  10  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  11  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  12  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  13  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  14  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0F, 0xFF, 0x00, 0x00, /*  15  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xF0, 0x00, 0x00, /*  16  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /* <17> */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xF0, 0x00, 0x00, /*  18  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0F, 0xFF, 0x00, 0x00, /*  19  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  20  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  21  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  22  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  23  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  24  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  25  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  26  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  27  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  28  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  29  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  30  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0F, 0xFF, 0x00, 0x00, /*  31  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xF0, 0x00, 0x00, /*  32  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  33  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  34  */
-};
-
-static const uint8_t digit_2[] = {
-	0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, /*   0  */
-	0x00, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0, 0x00, 0x00, 0x00, /*   1  */
-	0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0xF0, 0x00, 0x00, /*   2  */
-	0x00, 0x00, 0x0F, 0xFF, 0xFF, 0xFF, 0xF0, 0x0F, 0xFF, 0x00, 0x00, /*   3  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   4  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   5  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   6  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   7  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   8  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   9  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  10  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  11  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  12  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  13  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  14  */
-	0x00, 0x00, 0x0F, 0xFF, 0xFF, 0xFF, 0xF0, 0x0F, 0xFF, 0x00, 0x00, /*  15  */
-	0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0xF0, 0x00, 0x00, /*  16  */
-	0x00, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0, 0x00, 0x00, 0x00, /* <17> */
-	0x0F, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, /*  18  */
-	0xFF, 0xF0, 0x0F, 0xFF, 0xFF, 0xFF, 0xF0, 0x00, 0x00, 0x00, 0x00, /*  19  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  20  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  21  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  22  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  23  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  24  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  25  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  26  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  27  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  28  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  29  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  30  */
-	0xFF, 0xF0, 0x0F, 0xFF, 0xFF, 0xFF, 0xF0, 0x00, 0x00, 0x00, 0x00, /*  31  */
-	0x0F, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, /*  32  */
-	0x00, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0, 0x00, 0x00, 0x00, /*  33  */
-	0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, /*  34  */
-};
-
-static const uint8_t digit_3[] = {
-	0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, /*   0  */
-	0x00, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0, 0x00, 0x00, 0x00, /*   1  */
-	0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0xF0, 0x00, 0x00, /*   2  */
-	0x00, 0x00, 0x0F, 0xFF, 0xFF, 0xFF, 0xF0, 0x0F, 0xFF, 0x00, 0x00, /*   3  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   4  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   5  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   6  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   7  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   8  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   9  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  10  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  11  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  12  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  13  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  14  */
-	0x00, 0x00, 0x0F, 0xFF, 0xFF, 0xFF, 0xF0, 0x0F, 0xFF, 0x00, 0x00, /*  15  */
-	0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0xF0, 0x00, 0x00, /*  16  */
-	0x00, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0, 0x00, 0x00, 0x00, /* <17> */
-	0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0xF0, 0x00, 0x00, /*  18  */
-	0x00, 0x00, 0x0F, 0xFF, 0xFF, 0xFF, 0xF0, 0x0F, 0xFF, 0x00, 0x00, /*  19  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  20  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  21  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  22  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  23  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  24  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  25  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  26  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  27  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  28  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  29  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  30  */
-	0x00, 0x00, 0x0F, 0xFF, 0xFF, 0xFF, 0xF0, 0x0F, 0xFF, 0x00, 0x00, /*  31  */
-	0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0xF0, 0x00, 0x00, /*  32  */
-	0x00, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0, 0x00, 0x00, 0x00, /*  33  */
-	0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, /*  34  */
-};
-
-static const uint8_t digit_4[] = {
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   0  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   1  */
-	0x0F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xF0, 0x00, 0x00, /*   2  */
-	0xFF, 0xF0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0F, 0xFF, 0x00, 0x00, /*   3  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   4  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   5  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   6  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   7  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   8  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   9  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  10  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  11  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  12  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  13  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  14  */
-	0xFF, 0xF0, 0x0F, 0xFF, 0xFF, 0xFF, 0xF0, 0x0F, 0xFF, 0x00, 0x00, /*  15  */
-	0x0F, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0xF0, 0x00, 0x00, /*  16  */
-	0x00, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0, 0x00, 0x00, 0x00, /* <17> */
-	0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0xF0, 0x00, 0x00, /*  18  */
-	0x00, 0x00, 0x0F, 0xFF, 0xFF, 0xFF, 0xF0, 0x0F, 0xFF, 0x00, 0x00, /*  19  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  20  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  21  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  22  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  23  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  24  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  25  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  26  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  27  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  28  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  29  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  30  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0F, 0xFF, 0x00, 0x00, /*  31  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xF0, 0x00, 0x00, /*  32  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  33  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  34  */
-};
-
-static const uint8_t digit_5[] = {
-	0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, /*   0  */
-	0x00, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0, 0x00, 0x00, 0x00, /*   1  */
-	0x0F, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, /*   2  */
-	0xFF, 0xF0, 0x0F, 0xFF, 0xFF, 0xFF, 0xF0, 0x00, 0x00, 0x00, 0x00, /*   3  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   4  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   5  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   6  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   7  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   8  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   9  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  10  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  11  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  12  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  13  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  14  */
-	0xFF, 0xF0, 0x0F, 0xFF, 0xFF, 0xFF, 0xF0, 0x00, 0x00, 0x00, 0x00, /*  15  */
-	0x0F, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, /*  16  */
-	0x00, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0, 0x00, 0x00, 0x00, /* <17> */
-	0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0xF0, 0x00, 0x00, /*  18  */
-	0x00, 0x00, 0x0F, 0xFF, 0xFF, 0xFF, 0xF0, 0x0F, 0xFF, 0x00, 0x00, /*  19  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  20  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  21  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  22  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  23  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  24  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  25  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  26  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  27  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  28  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  29  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  30  */
-	0x00, 0x00, 0x0F, 0xFF, 0xFF, 0xFF, 0xF0, 0x0F, 0xFF, 0x00, 0x00, /*  31  */
-	0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0xF0, 0x00, 0x00, /*  32  */
-	0x00, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0, 0x00, 0x00, 0x00, /*  33  */
-	0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, /*  34  */
-};
-
-static const uint8_t digit_6[] = {
-	0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, /*   0  */
-	0x00, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0, 0x00, 0x00, 0x00, /*   1  */
-	0x0F, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, /*   2  */
-	0xFF, 0xF0, 0x0F, 0xFF, 0xFF, 0xFF, 0xF0, 0x00, 0x00, 0x00, 0x00, /*   3  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   4  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   5  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   6  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   7  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   8  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   9  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  10  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  11  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  12  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  13  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  14  */
-	0xFF, 0xF0, 0x0F, 0xFF, 0xFF, 0xFF, 0xF0, 0x00, 0x00, 0x00, 0x00, /*  15  */
-	0x0F, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, /*  16  */
-	0x00, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0, 0x00, 0x00, 0x00, /* <17> */
-	0x0F, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0xF0, 0x00, 0x00, /*  18  */
-	0xFF, 0xF0, 0x0F, 0xFF, 0xFF, 0xFF, 0xF0, 0x0F, 0xFF, 0x00, 0x00, /*  19  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  20  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  21  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  22  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  23  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  24  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  25  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  26  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  27  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  28  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  29  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  30  */
-	0xFF, 0xF0, 0x0F, 0xFF, 0xFF, 0xFF, 0xF0, 0x0F, 0xFF, 0x00, 0x00, /*  31  */
-	0x0F, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0xF0, 0x00, 0x00, /*  32  */
-	0x00, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0, 0x00, 0x00, 0x00, /*  33  */
-	0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, /*  34  */
-};
+/**
+ * seven-segment font: every segment is a few rectangles in pixels relative to
+ * the symbol, generated at compile time from the segment geometry, so any scan code
+ * is drawn and a font of any size is just another SEG_FONT(width, height)
+ */
+typedef struct seg_rect_s {
+	uint8_t x0, x1; /* pixels, x1 exclusive */
+	uint8_t y0, y1; /* rows, y1 exclusive */
+} seg_rect_t;
+
+#define SEG_NUM   8 /* A to G and the dot */
+#define SEG_RECTS 5 /* rectangles per segment */
+
+#define SEG_CLIP(y, h) ((y) < 0 ? 0 : (y) > (h) ? (h) : (y))
+/* one row of a horizontal segment, shorter by 'in' pixels from both ends, clipped to 'h' rows */
+#define SEG_HROW(x0, x1, y, h, in) { (x0) + (in), (x1) + 1 - (in), SEG_CLIP(y, h), SEG_CLIP((y) + 1, h) }
+/* horizontal segment, 5 rows with beveled ends, x0 to x1 is the middle row */
+#define SEG_H(x0, x1, y, h) { SEG_HROW(x0, x1, (y) - 2, h, 2), SEG_HROW(x0, x1, (y) - 1, h, 1), \
+	SEG_HROW(x0, x1, y, h, 0), SEG_HROW(x0, x1, (y) + 1, h, 1), SEG_HROW(x0, x1, (y) + 2, h, 2) }
+/* vertical segments, 4 pixels wide, rows y0 to y1, pointed ends are shifted to the symbol center */
+#define SEG_VL(x, y0, y1) { { (x) + 1, (x) + 2, y0, (y0) + 1 }, { x, (x) + 3, (y0) + 1, (y0) + 2 }, \
+	{ x, (x) + 4, (y0) + 2, (y1) - 1 }, { x, (x) + 3, (y1) - 1, y1 }, { (x) + 1, (x) + 2, y1, (y1) + 1 } }
+#define SEG_VR(x, y0, y1) { { (x) + 2, (x) + 3, y0, (y0) + 1 }, { (x) + 1, (x) + 4, (y0) + 1, (y0) + 2 }, \
+	{ x, (x) + 4, (y0) + 2, (y1) - 1 }, { (x) + 1, (x) + 4, (y1) - 1, y1 }, { (x) + 2, (x) + 3, y1, (y1) + 1 } }
+/* the dot is a 3x3 square right to the bottom of the symbol */
+#define SEG_DP(x, y) { { x, (x) + 3, y, (y) + 3 } }
+
+/* all segments of a font 'w' pixels wide and 'h' rows high, without the dot */
+#define SEG_FONT(w, h) { \
+	SEG_H(3, (w) - 4, 1, h),                        /* A */ \
+	SEG_VR((w) - 4, 2, (h) / 2 - 1),                /* B */ \
+	SEG_VR((w) - 4, (h) / 2 + 1, (h) - 3),          /* C */ \
+	SEG_H(3, (w) - 4, (h) - 2, h),                  /* D */ \
+	SEG_VL(0, (h) / 2 + 1, (h) - 3),                /* E */ \
+	SEG_VL(0, 2, (h) / 2 - 1),                      /* F */ \
+	SEG_H(3, (w) - 4, (h) / 2, h),                  /* G */ \
+	SEG_DP(w, (h) - 1) }                            /* dot */
+
+/* bounding boxes of the segments, used as dirty regions */
+#define SEG_FONT_BOX(w, h) { \
+	{ 3, (w) - 3, 0, 4 }, \
+	{ (w) - 4, (w), 2, (h) / 2 }, \
+	{ (w) - 4, (w), (h) / 2 + 1, (h) - 2 }, \
+	{ 3, (w) - 3, (h) - 4, h }, \
+	{ 0, 4, (h) / 2 + 1, (h) - 2 }, \
+	{ 0, 4, 2, (h) / 2 }, \
+	{ 3, (w) - 3, (h) / 2 - 2, (h) / 2 + 3 }, \
+	{ w, (w) + 3, (h) - 1, (h) + 2 } }
+
+/* small font with one pixel wide segments, 'h' rows include the 2x2 dot */
+#define SEG_FONT_THIN(w, h) { \
+	{ { 1, (w) - 1, 0, 1 } },                       /* A */ \
+	{ { (w) - 1, w, 1, (h) / 2 } },                 /* B */ \
+	{ { (w) - 1, w, (h) / 2 + 1, (h) - 1 } },       /* C */ \
+	{ { 1, (w) - 1, (h) - 1, h } },                 /* D */ \
+	{ { 0, 1, (h) / 2 + 1, (h) - 1 } },             /* E */ \
+	{ { 0, 1, 1, (h) / 2 } },                       /* F */ \
+	{ { 1, (w) - 1, (h) / 2, (h) / 2 + 1 } },       /* G */ \
+	{ { (w) + 1, (w) + 3, (h) - 2, h } } }          /* dot */
+
+/* every thin segment is a single rectangle, so it is the bounding box as well */
+#define SEG_FONT_THIN_BOX(w, h) { \
+	{ 1, (w) - 1, 0, 1 }, \
+	{ (w) - 1, w, 1, (h) / 2 }, \
+	{ (w) - 1, w, (h) / 2 + 1, (h) - 1 }, \
+	{ 1, (w) - 1, (h) - 1, h }, \
+	{ 0, 1, (h) / 2 + 1, (h) - 1 }, \
+	{ 0, 1, 1, (h) / 2 }, \
+	{ 1, (w) - 1, (h) / 2, (h) / 2 + 1 }, \
+	{ (w) + 1, (w) + 3, (h) - 2, h } }
+
+/* font placement in the frame */
+typedef struct seg_font_s {
+	const seg_rect_t (*seg)[SEG_RECTS]; /* rectangles of the segments */
+	const seg_rect_t *box; /* bounding boxes of the segments */
+	uint8_t x;     /* the first column of the position 1 */
+	uint8_t y;     /* the first frame row */
+	uint8_t pitch; /* pixels per position */
+} seg_font_t;
+
+/* segments of the 22x35 symbols, 18 pixels wide digit and the dot */
+static const seg_rect_t seg_font[SEG_NUM][SEG_RECTS] = SEG_FONT(OLED_DOT_OFFSET, OLED_FONT_CHAR_HEIGHT);
+static const seg_rect_t seg_box[SEG_NUM] = SEG_FONT_BOX(OLED_DOT_OFFSET, OLED_FONT_CHAR_HEIGHT);
+static const seg_font_t digits_font = { seg_font, seg_box, OLED_SYM_OFFSET, 0, OLED_FONT_WIDTH };
+/* the sign is the only segment G of the first position */
+static const seg_rect_t seg_sign = { 0, 9, OLED_SIGN_LINE, OLED_SIGN_LINE + OLED_FONT_SIGN_HEIGHT };
+
+#if OLED_INFO_LINE
+static const seg_rect_t info_seg[SEG_NUM][SEG_RECTS] = SEG_FONT_THIN(OLED_INFO_WIDTH, OLED_INFO_HEIGHT);
+static const seg_rect_t info_box[SEG_NUM] = SEG_FONT_THIN_BOX(OLED_INFO_WIDTH, OLED_INFO_HEIGHT);
+/* the sign of the info line is segment G of a regular position */
+static const seg_font_t info_font = { info_seg, info_box, OLED_INFO_OFFSET, OLED_INFO_ROW, OLED_INFO_PITCH };
 
-static const uint8_t digit_7[] = {
-	0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, /*   0  */
-	0x00, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0, 0x00, 0x00, 0x00, /*   1  */
-	0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0xF0, 0x00, 0x00, /*   2  */
-	0x00, 0x00, 0x0F, 0xFF, 0xFF, 0xFF, 0xF0, 0x0F, 0xFF, 0x00, 0x00, /*   3  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   4  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   5  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   6  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   7  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   8  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   9  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  10  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  11  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  12  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  13  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  14  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0F, 0xFF, 0x00, 0x00, /*  15  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xF0, 0x00, 0x00, /*  16  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /* <17> */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xF0, 0x00, 0x00, /*  18  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0F, 0xFF, 0x00, 0x00, /*  19  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  20  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  21  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  22  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  23  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  24  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  25  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  26  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  27  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  28  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  29  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  30  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0F, 0xFF, 0x00, 0x00, /*  31  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xF0, 0x00, 0x00, /*  32  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  33  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  34  */
-};
+#endif
 
-static const uint8_t digit_8[] = {
-	0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, /*   0  */
-	0x00, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0, 0x00, 0x00, 0x00, /*   1  */
-	0x0F, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0xF0, 0x00, 0x00, /*   2  */
-	0xFF, 0xF0, 0x0F, 0xFF, 0xFF, 0xFF, 0xF0, 0x0F, 0xFF, 0x00, 0x00, /*   3  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   4  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   5  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   6  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   7  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   8  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   9  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  10  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  11  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  12  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  13  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  14  */
-	0xFF, 0xF0, 0x0F, 0xFF, 0xFF, 0xFF, 0xF0, 0x0F, 0xFF, 0x00, 0x00, /*  15  */
-	0x0F, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0xF0, 0x00, 0x00, /*  16  */
-	0x00, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0, 0x00, 0x00, 0x00, /* <17> */
-	0x0F, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0xF0, 0x00, 0x00, /*  18  */
-	0xFF, 0xF0, 0x0F, 0xFF, 0xFF, 0xFF, 0xF0, 0x0F, 0xFF, 0x00, 0x00, /*  19  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  20  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  21  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  22  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  23  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  24  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  25  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  26  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  27  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  28  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  29  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  30  */
-	0xFF, 0xF0, 0x0F, 0xFF, 0xFF, 0xFF, 0xF0, 0x0F, 0xFF, 0x00, 0x00, /*  31  */
-	0x0F, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0xF0, 0x00, 0x00, /*  32  */
-	0x00, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0, 0x00, 0x00, 0x00, /*  33  */
-	0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, /*  34  */
+/* segments of the symbols, supported by MK-52 */
+static const uint8_t sym_seg[SYM_MAX] = {
+	[SYM_SPACE] = 0x00, [SYM_MINUS] = 0x40,
+	[SYM_0] = 0x3F, [SYM_1] = 0x06, [SYM_2] = 0x5B, [SYM_3] = 0x4F, [SYM_4] = 0x66,
+	[SYM_5] = 0x6D, [SYM_6] = 0x7D, [SYM_7] = 0x07, [SYM_8] = 0x7F, [SYM_9] = 0x6F,
+	[SYM_C] = 0x39, [SYM_E] = 0x79, [SYM_L] = 0x38, [SYM_R] = 0x31, [SYM_M1] = 0x46,
+	[SYM_RF] = 0x47, [SYM_RP] = 0x67
 };
 
-static const uint8_t digit_9[] = {
-	0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, /*   0  */
-	0x00, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0, 0x00, 0x00, 0x00, /*   1  */
-	0x0F, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0xF0, 0x00, 0x00, /*   2  */
-	0xFF, 0xF0, 0x0F, 0xFF, 0xFF, 0xFF, 0xF0, 0x0F, 0xFF, 0x00, 0x00, /*   3  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   4  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   5  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   6  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   7  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   8  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   9  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  10  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  11  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  12  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  13  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  14  */
-	0xFF, 0xF0, 0x0F, 0xFF, 0xFF, 0xFF, 0xF0, 0x0F, 0xFF, 0x00, 0x00, /*  15  */
-	0x0F, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0xF0, 0x00, 0x00, /*  16  */
-	0x00, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0, 0x00, 0x00, 0x00, /* <17> */
-	0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0xF0, 0x00, 0x00, /*  18  */
-	0x00, 0x00, 0x0F, 0xFF, 0xFF, 0xFF, 0xF0, 0x0F, 0xFF, 0x00, 0x00, /*  19  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  20  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  21  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  22  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  23  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  24  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  25  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  26  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  27  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  28  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  29  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  30  */
-	0x00, 0x00, 0x0F, 0xFF, 0xFF, 0xFF, 0xF0, 0x0F, 0xFF, 0x00, 0x00, /*  31  */
-	0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0xF0, 0x00, 0x00, /*  32  */
-	0x00, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0, 0x00, 0x00, 0x00, /*  33  */
-	0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, /*  34  */
-};
+/* x of a symbol position in pixels */
+static inline uint8_t seg_pos_x(const seg_font_t *font, uint8_t pos)
+{
+	return font->x + (pos - 1) * font->pitch;
+}
 
-static const uint8_t digit_c[] = {
-	0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, /*   0  */
-	0x00, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0, 0x00, 0x00, 0x00, /*   1  */
-	0x0F, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, /*   2  */
-	0xFF, 0xF0, 0x0F, 0xFF, 0xFF, 0xFF, 0xF0, 0x00, 0x00, 0x00, 0x00, /*   3  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   4  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   5  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   6  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   7  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   8  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   9  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  10  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  11  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  12  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  13  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  14  */
-	0xFF, 0xF0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  15  */
-	0x0F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  16  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /* <17> */
-	0x0F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  18  */
-	0xFF, 0xF0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  19  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  20  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  21  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  22  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  23  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  24  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  25  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  26  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  27  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  28  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  29  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  30  */
-	0xFF, 0xF0, 0x0F, 0xFF, 0xFF, 0xFF, 0xF0, 0x00, 0x00, 0x00, 0x00, /*  31  */
-	0x0F, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, /*  32  */
-	0x00, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0, 0x00, 0x00, 0x00, /*  33  */
-	0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, /*  34  */
-};
+static void seg_mark_dirty(uint8_t x, uint8_t y, const seg_rect_t *box)
+{
+	oled_mark_dirty((x + box->x0) / OLED_PPB, y + box->y0, (x + box->x1 + 1) / OLED_PPB, y + box->y1);
+}
 
-static const uint8_t digit_e[] = {
-	0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, /*   0  */
-	0x00, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0, 0x00, 0x00, 0x00, /*   1  */
-	0x0F, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, /*   2  */
-	0xFF, 0xF0, 0x0F, 0xFF, 0xFF, 0xFF, 0xF0, 0x00, 0x00, 0x00, 0x00, /*   3  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   4  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   5  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   6  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   7  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   8  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   9  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  10  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  11  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  12  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  13  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  14  */
-	0xFF, 0xF0, 0x0F, 0xFF, 0xFF, 0xFF, 0xF0, 0x00, 0x00, 0x00, 0x00, /*  15  */
-	0x0F, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, /*  16  */
-	0x00, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0, 0x00, 0x00, 0x00, /* <17> */
-	0x0F, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, /*  18  */
-	0xFF, 0xF0, 0x0F, 0xFF, 0xFF, 0xFF, 0xF0, 0x00, 0x00, 0x00, 0x00, /*  19  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  20  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  21  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  22  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  23  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  24  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  25  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  26  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  27  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  28  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  29  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  30  */
-	0xFF, 0xF0, 0x0F, 0xFF, 0xFF, 0xFF, 0xF0, 0x00, 0x00, 0x00, 0x00, /*  31  */
-	0x0F, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, /*  32  */
-	0x00, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0, 0x00, 0x00, 0x00, /*  33  */
-	0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, /*  34  */
-};
+/* bounding boxes of the segments are dirty regions */
+static void seg_mark_segs(const seg_font_t *font, uint8_t x, uint8_t segs)
+{
+	for (; segs; segs &= segs - 1)
+		seg_mark_dirty(x, font->y, &font->box[__builtin_ctz(segs)]);
+}
 
-static const uint8_t digit_l[] = {
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   0  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   1  */
-	0x0F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   2  */
-	0xFF, 0xF0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   3  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   4  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   5  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   6  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   7  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   8  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   9  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  10  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  11  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  12  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  13  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  14  */
-	0xFF, 0xF0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  15  */
-	0x0F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  16  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /* <17> */
-	0x0F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  18  */
-	0xFF, 0xF0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  19  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  20  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  21  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  22  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  23  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  24  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  25  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  26  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  27  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  28  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  29  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  30  */
-	0xFF, 0xF0, 0x0F, 0xFF, 0xFF, 0xFF, 0xF0, 0x00, 0x00, 0x00, 0x00, /*  31  */
-	0x0F, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, /*  32  */
-	0x00, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0, 0x00, 0x00, 0x00, /*  33  */
-	0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, /*  34  */
-};
 
-static const uint8_t digit_r[] = { /* this symbol looks like Russian letter 'Г' */
-	0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, /*   0  */
-	0x00, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0, 0x00, 0x00, 0x00, /*   1  */
-	0x0F, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, /*   2  */
-	0xFF, 0xF0, 0x0F, 0xFF, 0xFF, 0xFF, 0xF0, 0x00, 0x00, 0x00, 0x00, /*   3  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   4  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   5  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   6  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   7  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   8  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   9  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  10  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  11  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  12  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  13  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  14  */
-	0xFF, 0xF0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  15  */
-	0x0F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  16  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /* <17> */
-	0x0F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  18  */
-	0xFF, 0xF0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  19  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  20  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  21  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  22  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  23  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  24  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  25  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  26  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  27  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  28  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  29  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  30  */
-	0xFF, 0xF0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  31  */
-	0x0F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  32  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  33  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  34  */
-};
+uint8_t oled_print_seg(uint8_t pos, uint8_t seg)
+{
+	if (pos >= OLED_DIGITS) /* invalid symbol position */
+		return 0;
+	if (pos == 0) /* only '-' is valid for the sign */
+		seg &= SEG_G;
 
-static const uint8_t digit_16[] = { /* actually, this is '-1' in one position, similar to this: '˧' */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   0  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*   1  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xF0, 0x00, 0x00, /*   2  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0F, 0xFF, 0x00, 0x00, /*   3  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   4  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   5  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   6  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   7  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   8  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   9  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  10  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  11  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  12  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  13  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  14  */
-	0x00, 0x00, 0x0F, 0xFF, 0xFF, 0xFF, 0xF0, 0x0F, 0xFF, 0x00, 0x00, /*  15  */
-	0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0xF0, 0x00, 0x00, /*  16  */
-	0x00, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0, 0x00, 0x00, 0x00, /* <17> */
-	0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0xF0, 0x00, 0x00, /*  18  */
-	0x00, 0x00, 0x0F, 0xFF, 0xFF, 0xFF, 0xF0, 0x0F, 0xFF, 0x00, 0x00, /*  19  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  20  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  21  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  22  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  23  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  24  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  25  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  26  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  27  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  28  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  29  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  30  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0F, 0xFF, 0x00, 0x00, /*  31  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xF0, 0x00, 0x00, /*  32  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  33  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  34  */
-};
+	uint16_t bit = 1u << pos;
+	if (!(sym_stale & bit) && oled_sym[pos] == seg) /* already there, nothing to do */
+		return 0;
 
-static const uint8_t digit_17[] = { /* this symbol looks like '-7' in one position or reversed 'F': 'ꟻ' */
-	0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, /*   0  */
-	0x00, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0, 0x00, 0x00, 0x00, /*   1  */
-	0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0xF0, 0x00, 0x00, /*   2  */
-	0x00, 0x00, 0x0F, 0xFF, 0xFF, 0xFF, 0xF0, 0x0F, 0xFF, 0x00, 0x00, /*   3  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   4  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   5  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   6  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   7  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   8  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   9  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  10  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  11  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  12  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  13  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  14  */
-	0x00, 0x00, 0x0F, 0xFF, 0xFF, 0xFF, 0xF0, 0x0F, 0xFF, 0x00, 0x00, /*  15  */
-	0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0xF0, 0x00, 0x00, /*  16  */
-	0x00, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0, 0x00, 0x00, 0x00, /* <17> */
-	0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0xF0, 0x00, 0x00, /*  18  */
-	0x00, 0x00, 0x0F, 0xFF, 0xFF, 0xFF, 0xF0, 0x0F, 0xFF, 0x00, 0x00, /*  19  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  20  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  21  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  22  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  23  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  24  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  25  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  26  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  27  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  28  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  29  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  30  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0F, 0xFF, 0x00, 0x00, /*  31  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xF0, 0x00, 0x00, /*  32  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  33  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  34  */
-};
+	/* only changed segments are drawn, all of them if the frame was cleared */
+	uint8_t diff = (sym_stale & bit) ? 0xFF : oled_sym[pos] ^ seg;
+	oled_sym[pos] = seg;
+	sym_stale &= ~bit;
 
-static const uint8_t digit_18[] = { /* this symbol looks like reversed 'P': 'ꟼ' */
-	0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, /*   0  */
-	0x00, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0, 0x00, 0x00, 0x00, /*   1  */
-	0x0F, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0xF0, 0x00, 0x00, /*   2  */
-	0xFF, 0xF0, 0x0F, 0xFF, 0xFF, 0xFF, 0xF0, 0x0F, 0xFF, 0x00, 0x00, /*   3  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   4  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   5  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   6  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   7  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   8  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*   9  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  10  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  11  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  12  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  13  */
-	0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  14  */
-	0xFF, 0xF0, 0x0F, 0xFF, 0xFF, 0xFF, 0xF0, 0x0F, 0xFF, 0x00, 0x00, /*  15  */
-	0x0F, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0xF0, 0x00, 0x00, /*  16  */
-	0x00, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0, 0x00, 0x00, 0x00, /* <17> */
-	0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0xF0, 0x00, 0x00, /*  18  */
-	0x00, 0x00, 0x0F, 0xFF, 0xFF, 0xFF, 0xF0, 0x0F, 0xFF, 0x00, 0x00, /*  19  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  20  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  21  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  22  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  23  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  24  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  25  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  26  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  27  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  28  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  29  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, /*  30  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0F, 0xFF, 0x00, 0x00, /*  31  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xF0, 0x00, 0x00, /*  32  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  33  */
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*  34  */
-};
+	if (oled_cells[pos].color != (uint8_t)font_color)
+		diff = 0xFF; /* the whole cell has the same color */
+	oled_cells[pos].sym = seg;
+	oled_cells[pos].color = (uint8_t)font_color;
 
-static const uint8_t digit_sign[] = {
-	0x00, 0x00, 0x00, 0x00, 0x00,
-	0x00, 0x00, 0x00, 0x00, 0x00,
-	0x00, 0x00, 0x00, 0x00, 0x00,
+	if (pos == 0) {
+		seg_mark_dirty(0, 0, &seg_sign);
+		return 1;
+	}
+	seg_mark_segs(&digits_font, seg_pos_x(&digits_font, pos), diff);
+	return 1;
+}
 
-	0xFF, 0xFF, 0xFF, 0xFF, 0xF0,
-	0xFF, 0xFF, 0xFF, 0xFF, 0xF0,
-	0xFF, 0xFF, 0xFF, 0xFF, 0xF0,
-};
+uint8_t oled_print(uint8_t pos, uint8_t sym)
+{
+	if ((sym & ~SEG_DOT) >= SYM_MAX) /* invalid symbol */
+		return 0;
+	return oled_print_seg(pos, sym_seg[sym & ~SEG_DOT] | (sym & SEG_DOT));
+}
 
-static const uint8_t digit_dot[] = {
-	0x00, 0x00,
-	0x00, 0x00,
-	0x00, 0x00,
+#if OLED_INFO_LINE
+uint8_t oled_print_info(const uint8_t *segs)
+{
+	uint8_t printed = 0;
+
+	for (uint8_t pos = 0; pos < OLED_DIGITS; pos++) {
+		uint8_t seg = pos ? segs[pos] : (segs[0] & SEG_G);
+		uint8_t diff = info_stale ? 0xFF : info_sym[pos] ^ seg;
+		if (!diff)
+			continue;
+		info_sym[pos] = seg;
+		uint8_t x = seg_pos_x(&info_font, pos);
+		info_cells[pos].sym = seg;
+		info_cells[pos].color = (uint8_t)font_color;
+		seg_mark_segs(&info_font, x, diff);
+		printed++;
+	}
+	info_stale = false;
+	return printed;
+}
+#endif
 
-	0xFF, 0xF0,
-	0xFF, 0xF0,
-	0xFF, 0xF0,
-};
+/* segments of the font crossing a row of the symbols */
+static uint8_t seg_line_mask(const seg_font_t *font, uint8_t y)
+{
+	uint8_t line_segs = 0;
+	for (uint8_t i = 0; i < SEG_NUM; i++)
+		if (y >= font->box[i].y0 && y < font->box[i].y1)
+			line_segs |= 1u << i;
+	return line_segs;
+}
 
-static const uint8_t *font[SYM_MAX] = {
-	digit_space, digit_minus,
-	/* digits 0 to 9 */
-	digit_0, digit_1, digit_2, digit_3,	digit_4,
-	digit_5, digit_6, digit_7, digit_8,	digit_9,
-	/* some special symbols */
-	digit_c, digit_e, digit_l, digit_r,	digit_16,
-	digit_17, digit_18
-};
+/* draw one row of the segments of a symbol to the line */
+static void expand_segs(uint8_t *buf, const seg_font_t *font, uint8_t x, uint8_t y, uint8_t segs, uint8_t color)
+{
+	for (; segs; segs &= segs - 1) {
+		const seg_rect_t *seg = font->seg[__builtin_ctz(segs)];
+		for (uint8_t i = 0; i < SEG_RECTS; i++) {
+			if (y >= seg[i].y0 && y < seg[i].y1)
+				raster_span(buf, x + seg[i].x0, x + seg[i].x1, color);
+		}
+	}
+}
 
 /**
- * copy a symbols to the frame buffer
- * @param pos: symbol position 0 to 11, 0: sign, 1: first digit, ..
- * @param sym: high bit: dot is present, lower 7 bits: supported symbol index 0 to 18, or > 18 for number's sign
- * @param color: grayscale index to use, 0 (black) to 15 (brightest white)
- *
- * @return 1 if printed, 0 otherwise
+ * expand one line of the cells snapshot to pixels, drawing only segments crossing the line
+ * @param rect: region being sent, only its columns are byte-swapped for 16 bit SPI
  */
-uint8_t oled_print(uint8_t pos, uint8_t sym)
+static void expand_line(uint8_t *buf, uint8_t y, const oled_rect_t *rect)
 {
-	if (pos >= OLED_DIGITS) /* invalid symbol position */
-		return 0;
-
-	if (oled_sym[pos] == sym) /* already there, nothing to do */
-		return 0;
-
-	uint8_t diff = oled_sym[pos] ^ sym; /* check if difference is the 'dot' only */
-	uint8_t dot = sym & SEG_DOT;
-	oled_sym[pos] = sym;
-	sym &= ~SEG_DOT;
+	uint32_t ts = DWT->CYCCNT;
 
-	if (sym >= SYM_MAX) /* invalid symbol */
-		return 0;
+	memset(buf, tx.bkg, OLED_LINE_SIZE);
+	if (y < OLED_FONT_HEIGHT) {
+		if (tx.indicator && y >= OLED_INDICATOR_LINE)
+			raster_span(buf, 0, OLED_INDICATOR_WIDTH, tx.indicator);
 
-	const uint8_t *ptr;
+		/* the sign symbol */
+		if ((tx.cell[0].sym & SEG_G) && y >= seg_sign.y0 && y < seg_sign.y1)
+			raster_span(buf, seg_sign.x0, seg_sign.x1, tx.cell[0].color);
 
-	/* the sign symbol */
-	if (pos == 0) {
-		ptr = digit_sign;
-		if (sym == SYM_MINUS)
-			ptr += sizeof(digit_sign) / 2;
-		for (uint8_t y = 0; y < OLED_FONT_SIGN_HEIGHT; y++) {
-			uint16_t pos = OLED_SIGN_LINE * OLED_LINE_SIZE + y * OLED_LINE_SIZE;
-			*(uint32_t *)&oled_frame[pos] = *(uint32_t *)ptr & font_color;
-			oled_frame[pos + 4] = ptr[4] & font_color;
-		}
-		return 1;
+		uint8_t line_segs = seg_line_mask(&digits_font, y);
+		for (uint8_t pos = 1; pos < OLED_DIGITS; pos++)
+			expand_segs(buf, &digits_font, seg_pos_x(&digits_font, pos), y,
+						tx.cell[pos].sym & line_segs, tx.cell[pos].color);
+	}
+#if OLED_INFO_LINE
+	else if (y >= OLED_INFO_ROW) {
+		y -= OLED_INFO_ROW;
+		uint8_t line_segs = seg_line_mask(&info_font, y);
+		for (uint8_t pos = 0; pos < OLED_DIGITS; pos++)
+			expand_segs(buf, &info_font, seg_pos_x(&info_font, pos), y,
+						tx.info[pos].sym & line_segs, tx.info[pos].color);
+		y += OLED_INFO_ROW;
 	}
+#endif
 
-	/* full-size symbol */
-	pos -= 1;
-	if (diff != SEG_DOT) {
-		ptr = font[sym];
-		/* symbols are actually 9 bytes wide, so split 9 bytes to two 32bit + 16bit */
-		for (uint8_t y = 0; y < OLED_FONT_CHAR_HEIGHT; y++) {
-			uint16_t x = OLED_SYM_OFFSET / OLED_PPB + pos * OLED_FONT_WIDTH / OLED_PPB + y * OLED_LINE_SIZE;
-			*(uint32_t *)&oled_frame[x + 0] = *(uint32_t *)&ptr[y * OLED_FONT_WIDTH / OLED_PPB + 0] & font_color;
-			*(uint32_t *)&oled_frame[x + 4] = *(uint32_t *)&ptr[y * OLED_FONT_WIDTH / OLED_PPB + 4] & font_color;
-			*(uint16_t *)&oled_frame[x + 8] = *(uint16_t *)&ptr[y * OLED_FONT_WIDTH / OLED_PPB + 8] & font_color;
-		}
+	if (spi16) {
+		uint16_t *data = (uint16_t *)&buf[rect->x0];
+		for (uint8_t i = 0; i < (rect->x1 - rect->x0) / 2; i++)
+			data[i] = __builtin_bswap16(data[i]);
 	}
+	ts = DWT->CYCCNT - ts;
+	render_clocks += ts;
+#if OLED_INFO_LINE
+	if (y >= OLED_INFO_ROW)
+		info_clocks += ts;
+#endif
+}
+
+static uint8_t print_mask(const uint8_t *syms, uint16_t mask, uint8_t (*print)(uint8_t, uint8_t))
+{
+	uint8_t printed = 0;
 
-	ptr = digit_dot;
-	if (dot)
-		ptr += sizeof(digit_dot) / 2;
-	for (uint8_t y = 0; y < OLED_FONT_DOT_HEIGHT; y++) {
-		uint16_t x = OLED_SYM_OFFSET / OLED_PPB + OLED_DOT_OFFSET / OLED_PPB
-						+ pos * OLED_FONT_WIDTH / OLED_PPB
-						+ (OLED_FONT_HEIGHT - OLED_FONT_DOT_HEIGHT) * OLED_LINE_SIZE
-						+ y * OLED_LINE_SIZE;
-		*(uint16_t *)&oled_frame[x] = *(uint16_t *)ptr & font_color;
+	mask = (mask | sym_stale) & ((1u << OLED_DIGITS) - 1);
+	while (mask) {
+		uint8_t pos = __builtin_ctz(mask);
+		mask &= mask - 1;
+		printed += print(pos, syms[pos]);
 	}
+	return printed;
+}
 
-	return 1;
-}
\ No newline at end of file
+uint8_t oled_print_mask(const uint8_t *syms, uint16_t mask)
+{
+	return print_mask(syms, mask, oled_print);
+}
+
+uint8_t oled_print_seg_mask(const uint8_t *segs, uint16_t mask)
+{
+	return print_mask(segs, mask, oled_print_seg);
+}
@@ -34,6 +34,38 @@ extern "C" {
 #define OLED_SIGN_LINE  15 /* at which line the sign is located */
 #define OLED_SYM_OFFSET 14 /* the first column of the first digit */
 #define OLED_DOT_OFFSET 18 /* dot position offset within a symbol */
+/* program running indicator under the sign, as high as the dot */
+#define OLED_INDICATOR_LINE  (OLED_FONT_HEIGHT - OLED_FONT_DOT_HEIGHT)
+#define OLED_INDICATOR_WIDTH 9
+
+#define OLED_SPI16 1 /* use 16 bit SPI frames by default */
+#define OLED_FLUSH_RATE 60 /* max flushes per second by oled_flush_poll(), 0 for no limit */
+/**
+ * drive only OLED_FRAME_HEIGHT rows by the multiplex ratio instead of all 64,
+ * rows are scanned more often and unused rows are not driven at all,
+ * RAM clear is shortened to the driven rows as well
+ */
+#define OLED_GLYPH_ROWS  1
+#define OLED_ROWS_OFFSET ((OLED_HEIGHT - OLED_FRAME_HEIGHT) / 2) /* the first driven COM, to center the rows */
+#define OLED_ROWS_OSC_FREQ SH1122_OSC_FREQ_POR /* oscillator frequency in the glyph rows mode */
+/**
+ * secondary info line in a small seven-segment font under the digits, in rows
+ * not used by them, drawn and flushed as its own dirty regions
+ */
+#define OLED_INFO_LINE   1
+#define OLED_INFO_ROW    (OLED_FONT_HEIGHT + 2) /* the first frame row of the info line */
+#define OLED_INFO_WIDTH  6  /* symbol width without the dot */
+#define OLED_INFO_HEIGHT 11 /* symbol height, the dot included */
+#define OLED_INFO_PITCH  10 /* pixels per position: symbol, dot and a gap */
+/* the first digit of the info line, so the last one is right aligned with the digits */
+#define OLED_INFO_OFFSET (OLED_WIDTH - (OLED_DIGITS - 1) * OLED_INFO_PITCH)
+
+/* rows of the frame: digits and the info line */
+#if OLED_INFO_LINE
+#define OLED_FRAME_HEIGHT (OLED_INFO_ROW + OLED_INFO_HEIGHT)
+#else
+#define OLED_FRAME_HEIGHT OLED_FONT_HEIGHT
+#endif
 
 #define OLED_COLOR_BLACK 0x00
 #define OLED_COLOR_DIM   0x01
@@ -41,6 +73,9 @@ extern "C" {
 #define OLED_COLOR_WHITE 0x0F
 
 #define OLED_DEFAULT_FONT_COLOR OLED_COLOR_GRAY
+#define OLED_DEFAULT_CONTRAST   0x80 /* SH1122 reset value */
+#define OLED_DIM_SHIFT          3    /* contrast is divided by 8 when dimmed */
+#define OLED_BLANK_CONTRAST     0    /* blank by zero contrast instead of the display off command */
 #define OLED_DEFAULT_BKG_COLOR  OLED_COLOR_BLACK
 
 enum MK52_SYM {
@@ -94,8 +129,14 @@ static inline void oled_rst_stop(void) {
 
 extern uint8_t oled_rotated; /* 0 for the default, anything else for 180 rotation */
 
-/* frame buffer, holds only portion of RAM used by digits */
-extern uint8_t oled_frame[OLED_LINE_SIZE * OLED_FONT_HEIGHT];
+/* symbol cell of the frame */
+typedef struct oled_cell_s {
+	uint8_t sym;   /** segments with the dot bit */
+	uint8_t color; /** font color, both nibbles */
+} oled_cell_t;
+
+/* RAM used by the frame representation and flush buffers, bytes */
+uint32_t oled_frame_ram(void);
 
 /* used by oled_init(), does not make sense to use separately */
 void oled_reset(void);
@@ -113,10 +154,19 @@ void oled_send_cmd_arg(uint8_t cmd, uint8_t arg);
 /* send data to SH1122 */
 void oled_send_data(uint8_t *data, uint16_t len);
 
-/* frame buffer drawing primitives */
-void oled_set_pixel(uint16_t x, uint16_t y, uint8_t color);
-void oled_draw_line(uint8_t x, uint8_t y, uint16_t len, uint8_t color);
-void oled_draw_row(uint8_t x, uint8_t y, uint8_t hight, uint8_t color);
+/**
+ * drive only OLED_FRAME_HEIGHT rows or all rows of the panel,
+ * RAM is cleared with the current background color
+ */
+void oled_set_glyph_rows(bool on);
+bool oled_is_glyph_rows(void);
+
+/**
+ * switch between 8 and 16 bit SPI frames, with 16 bit frames
+ * single-byte commands are padded with SH1122_CMD_NOP
+ */
+void oled_set_spi16(bool on);
+bool oled_is_spi16(void);
 
 /**
  * set color to eb used by oled_print
@@ -124,6 +174,28 @@ void oled_draw_row(uint8_t x, uint8_t y, uint8_t hight, uint8_t color);
  */
 void oled_set_font_color(uint8_t color);
 
+/**
+ * set display brightness by SH1122 contrast, so symbols in the frame are not changed
+ * and nothing has to be re-drawn or flushed. If a flush is in progress then
+ * the contrast is sent by the next oled_flush_start()
+ * @param contrast: 0 to 255
+ */
+void oled_set_contrast(uint8_t contrast);
+uint8_t oled_get_contrast(void);
+
+/** @param dimmed: true to reduce contrast by OLED_DIM_SHIFT, used while a program is running */
+void oled_set_dimmed(bool dimmed);
+
+/**
+ * blank the display by the display off command, or zero contrast if OLED_BLANK_CONTRAST is set,
+ * the frame is kept, so nothing has to be re-drawn or flushed to show it again.
+ * Commands are deferred while a flush is in progress, as for oled_set_contrast()
+ */
+void oled_set_blanked(bool blanked);
+
+/* show or hide the program running indicator with the font color, hidden by oled_clear_frame() */
+void oled_set_indicator(bool on);
+
 /**
  * copy a symbols to the frame buffer
  * @param pos: symbol position 0 to OLED_DIGITS, 0: sign, 1: first digit, ..
@@ -133,11 +205,119 @@ void oled_set_font_color(uint8_t color);
  */
 uint8_t oled_print(uint8_t x, uint8_t sym);
 
-/* flush frame buffer to OLED RAM */
-static inline void oled_flush_frame(void) {
-	oled_send_data(oled_frame, sizeof(oled_frame));
-	oled_send_cmd_arg(0xB0, 32 * oled_rotated); /* reset row */
-}
+/**
+ * print symbols of positions set in the mask, stale positions are always printed
+ * @param syms: OLED_DIGITS symbols as for oled_print(), only printed positions are used
+ * @param mask: bit per symbol position
+ *
+ * @return number of printed symbols
+ */
+uint8_t oled_print_mask(const uint8_t *syms, uint16_t mask);
+
+/**
+ * draw segments of a scan code, not only supported symbols
+ * @param pos: symbol position 0 to OLED_DIGITS, only segment G is drawn at the sign position 0
+ * @param seg: SEG_A to SEG_G and SEG_DOT bits
+ *
+ * @return 1 if printed, 0 otherwise
+ */
+uint8_t oled_print_seg(uint8_t pos, uint8_t seg);
+
+/* as oled_print_mask() but for scan codes */
+uint8_t oled_print_seg_mask(const uint8_t *segs, uint16_t mask);
+
+#if OLED_INFO_LINE
+/**
+ * print scan codes to the info line, only changed segments are drawn and marked dirty,
+ * within the info line rows, so the digits are never sent again because of it.
+ * All positions are printed again after the frame clear or font color change
+ * @param segs: OLED_DIGITS scan codes, only '-' is drawn at the sign position 0
+ *
+ * @return number of printed positions
+ */
+uint8_t oled_print_info(const uint8_t *segs);
+#endif
+
+/* mask of positions which must be printed again after the frame clear or font color change */
+uint16_t oled_stale_mask(void);
+
+/* mark all positions as stale, so they will be printed again */
+void oled_invalidate(void);
+
+/**
+ * mark region of the frame to be sent by the next flush
+ * @param x0, x1: the first and the last + 1 frame columns in bytes (two pixels)
+ * @param y0, y1: the first and the last + 1 frame rows
+ */
+void oled_mark_dirty(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1);
+
+/**
+ * start sending dirty regions of the frame to OLED RAM by DMA, using column/row windows,
+ * or the whole frame if it is cheaper. The symbol cells are copied to a snapshot, which is
+ * expanded to pixels line by line while it is sent, so printing can continue while the flush
+ * is in progress
+ *
+ * @return false if there is nothing to flush or previous flush is still in progress,
+ *         dirty regions are kept for the next call then
+ */
+bool oled_flush_start(void);
+
+/**
+ * rate limited oled_flush_start(): changes drawn between flushes are coalesced
+ * and sent together, call it every main loop iteration, so the last change
+ * is sent not later than one period after the previous flush
+ *
+ * @return true if a flush is started
+ */
+bool oled_flush_poll(void);
+
+/** @param rate: max flushes per second, 0 for no limit */
+void oled_set_flush_rate(uint16_t rate);
+uint16_t oled_get_flush_rate(void);
+
+/* true if flush or RAM clear is in progress */
+bool oled_flush_busy(void);
+
+/* wait for the flush in progress to complete */
+void oled_flush_wait(void);
+
+/* blocking flush of dirty regions */
+void oled_flush_frame(void);
+
+/* SPI DMA transfer complete interrupt handler */
+void oled_flush_isr(void);
+
+/* called from the interrupt context when a flush or RAM clear is complete, weak, can be overridden */
+void oled_flush_callback(void);
+
+typedef struct oled_stats_s {
+	uint32_t bytes;   /** data bytes sent by the last flush */
+	uint32_t clocks;  /** sys clocks from the start to the end of the last flush */
+	uint32_t copy_clocks; /** sys clocks spent in oled_flush_start() taking the cells snapshot */
+	uint32_t render_clocks; /** sys clocks spent drawing symbols for the last flush */
+	uint32_t info_bytes;  /** data bytes of the info line rows, included in 'bytes' */
+	uint32_t info_clocks; /** sys clocks spent drawing the info line, included in 'render_clocks' */
+	uint8_t  regions; /** number of regions flushed */
+} oled_stats_t;
+
+extern oled_stats_t oled_stats;
+
+/* load of completed flushes since the last oled_load_reset() */
+typedef struct oled_load_s {
+	uint32_t start;      /** millis() of the reset */
+	uint32_t flushes;    /** number of flushes */
+	uint64_t spi_clocks; /** sys clocks of flushes from the start to the end */
+	uint64_t cpu_clocks; /** sys clocks spent rendering symbols and taking snapshots */
+	uint32_t lat_max;    /** the longest time from marking a region dirty to the end of its flush, sys clocks */
+	uint64_t lat_sum;    /** sum of flush latencies */
+	uint64_t bytes;      /** data bytes sent */
+	uint64_t info_bytes; /** data bytes of the info line rows */
+	uint64_t info_clocks; /** sys clocks spent drawing the info line */
+} oled_load_t;
+
+extern oled_load_t oled_load;
+
+void oled_load_reset(void);
 
 /* clear oled frame using provided color 0-15 */
 void oled_clear_frame(uint8_t fill);
@@ -159,6 +339,7 @@ void oled_clear_ram(uint8_t fill);
 #define SH1122_CMD_SET_LINE 	0x40 /* set RAM line as the start of scan */
 
 #define SH1122_CMD_SET_CONTRAST 0x81
+#define SH1122_DEFAULT_CONTRAST 0x80
 
 #define SH1122_CMD_SET_DIR_NORMAL  0xA0
 #define SH1122_CMD_SET_DIR_REVERSE 0xA1
@@ -194,6 +375,7 @@ void oled_clear_ram(uint8_t fill);
 #define SH1122_CMD_SET_OSC_MODE 0xD5
 	#define SH1122_OSC_MODE_RATION_MASK 0x0F /** 0 invalid, 2 DCLK POR */
 	#define SH1122_OSC_MODE_FREQ_MASK 0x0F	 /** 0 invalid, 2 DCLK POR */
+	#define SH1122_OSC_FREQ_POR 5 /** 100% */
 
 #define SH1122_CMD_SET_CHARGE_PERIOD 0xD9
 	#define SH1122_PRECHARGE_MASK 0x0F
@@ -0,0 +1,121 @@
+/**
+ * 4 bit per pixel raster drawing.
+ *
+ * MIT License
+ */
+#include <string.h>
+
+#include "raster.h"
+
+void raster_span(uint8_t *row, uint16_t x0, uint16_t x1, uint8_t fill)
+{
+	if (x0 >= x1)
+		return;
+	/* nibble edges */
+	if (x0 & 1) {
+		row[x0 / 2] = (row[x0 / 2] & 0xF0) | (fill & 0x0F);
+		x0++;
+	}
+	if (x1 & 1) {
+		x1--;
+		row[x1 / 2] = (row[x1 / 2] & 0x0F) | (fill & 0xF0);
+	}
+
+	uint8_t *dst = &row[x0 / 2];
+	uint8_t *end = &row[x1 / 2];
+	/* bytes up to the word boundary, whole words, and the rest */
+	while (dst < end && ((uintptr_t)dst & 3))
+		*dst++ = fill;
+	uint32_t word = fill * 0x01010101u;
+	for (; end - dst >= 4; dst += 4)
+		*(uint32_t *)dst = word;
+	while (dst < end)
+		*dst++ = fill;
+}
+
+bool raster_clip(const raster_t *r, int16_t *x, int16_t *y, int16_t *w, int16_t *h, int16_t *sx, int16_t *sy)
+{
+	if (*x < 0) {
+		*w += *x;
+		if (sx)
+			*sx -= *x;
+		*x = 0;
+	}
+	if (*y < 0) {
+		*h += *y;
+		if (sy)
+			*sy -= *y;
+		*y = 0;
+	}
+	if (*x + *w > r->width)
+		*w = r->width - *x;
+	if (*y + *h > r->height)
+		*h = r->height - *y;
+	return *w > 0 && *h > 0;
+}
+
+void raster_set_pixel(const raster_t *r, int16_t x, int16_t y, uint8_t color)
+{
+	if (x < 0 || y < 0 || x >= r->width || y >= r->height)
+		return;
+	uint8_t *dst = &r->buf[y * r->stride + x / 2];
+	if (x & 1)
+		*dst = (*dst & 0xF0) | (color & 0x0F);
+	else
+		*dst = (*dst & 0x0F) | (color << 4);
+}
+
+uint8_t raster_get_pixel(const raster_t *r, int16_t x, int16_t y)
+{
+	if (x < 0 || y < 0 || x >= r->width || y >= r->height)
+		return 0;
+	uint8_t data = r->buf[y * r->stride + x / 2];
+	return (x & 1) ? (data & 0x0F) : (data >> 4);
+}
+
+void raster_fill_rect(const raster_t *r, int16_t x, int16_t y, int16_t w, int16_t h, uint8_t color)
+{
+	if (!raster_clip(r, &x, &y, &w, &h, NULL, NULL))
+		return;
+	uint8_t fill = raster_fill(color);
+	uint8_t *row = &r->buf[y * r->stride];
+	for (; h; h--, row += r->stride)
+		raster_span(row, x, x + w, fill);
+}
+
+void raster_blit(const raster_t *r, int16_t x, int16_t y, const uint8_t *src, uint16_t stride, int16_t w, int16_t h)
+{
+	int16_t sx = 0, sy = 0;
+
+	if (!raster_clip(r, &x, &y, &w, &h, &sx, &sy))
+		return;
+
+	uint8_t *row = &r->buf[y * r->stride];
+	src += sy * stride;
+	for (; h; h--, row += r->stride, src += stride) {
+		uint16_t dx = x, px = sx, n = w;
+		/* the first pixel to the low nibble */
+		if (dx & 1) {
+			uint8_t pix = (px & 1) ? src[px / 2] & 0x0F : src[px / 2] >> 4;
+			row[dx / 2] = (row[dx / 2] & 0xF0) | pix;
+			dx++, px++, n--;
+		}
+		uint8_t *dst = &row[dx / 2];
+		const uint8_t *s = &src[px / 2];
+		if (!(px & 1)) {
+			/* nibbles are in the same places, copy bytes */
+			memcpy(dst, s, n / 2);
+			dst += n / 2;
+			s += n / 2;
+			if (n & 1)
+				*dst = (*dst & 0x0F) | (*s & 0xF0);
+		} else {
+			/* every destination byte is made of two source bytes */
+			uint16_t i;
+			for (i = 0; i < n / 2; i++)
+				dst[i] = (s[i] << 4) | (s[i + 1] >> 4);
+			if (n & 1)
+				dst[i] = (dst[i] & 0x0F) | (s[i] << 4);
+		}
+	}
+}
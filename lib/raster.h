@@ -0,0 +1,77 @@
+/**
+ * 4 bit per pixel raster drawing: two pixels per byte, the left pixel
+ * is in the high nibble, as used by SH1122 RAM and the OLED line buffers.
+ *
+ * Horizontal runs are filled by whole words with masked nibbles at the edges,
+ * so rectangles and lines cost a few stores per row instead of
+ * a read-modify-write per pixel.
+ *
+ * Does not depend on HAL or any STM32 peripherals, so it can be built
+ * for a host.
+ *
+ * MIT License
+ */
+#ifndef MK52_RASTER_H
+#define MK52_RASTER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct raster_s {
+	uint8_t *buf;    /** the first row, word aligned for word-wide fills */
+	uint16_t stride; /** bytes per row */
+	uint16_t width;  /** pixels */
+	uint16_t height; /** rows */
+} raster_t;
+
+/** 4 bit color in both nibbles of a byte */
+static inline uint8_t raster_fill(uint8_t color) {
+	return (color & 0x0F) * 0x11;
+}
+
+/**
+ * fill pixels of one row, no clipping
+ * @param x0, x1: the first and the last + 1 pixels
+ * @param fill: color in both nibbles, see raster_fill()
+ */
+void raster_span(uint8_t *row, uint16_t x0, uint16_t x1, uint8_t fill);
+
+/**
+ * clip a rectangle to the raster
+ * @param x, y, w, h: rectangle in pixels, updated to the visible part
+ * @param sx, sy: source offsets to be advanced by the clipped amount, can be NULL
+ *
+ * @return false if nothing is visible
+ */
+bool raster_clip(const raster_t *r, int16_t *x, int16_t *y, int16_t *w, int16_t *h, int16_t *sx, int16_t *sy);
+
+void raster_set_pixel(const raster_t *r, int16_t x, int16_t y, uint8_t color);
+uint8_t raster_get_pixel(const raster_t *r, int16_t x, int16_t y);
+
+/* rectangle, horizontal and vertical lines, clipped, color 0 to 15 */
+void raster_fill_rect(const raster_t *r, int16_t x, int16_t y, int16_t w, int16_t h, uint8_t color);
+
+static inline void raster_hline(const raster_t *r, int16_t x, int16_t y, int16_t len, uint8_t color) {
+	raster_fill_rect(r, x, y, len, 1, color);
+}
+
+static inline void raster_vline(const raster_t *r, int16_t x, int16_t y, int16_t len, uint8_t color) {
+	raster_fill_rect(r, x, y, 1, len, color);
+}
+
+/**
+ * copy a 4 bpp image, clipped
+ * @param src: the first row of the image, the left pixel in the high nibble
+ * @param stride: bytes per image row
+ * @param w, h: image size in pixels
+ */
+void raster_blit(const raster_t *r, int16_t x, int16_t y, const uint8_t *src, uint16_t stride, int16_t w, int16_t h);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
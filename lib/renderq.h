@@ -0,0 +1,112 @@
+/**
+ * Render queue between decode and render stages of the display pipeline.
+ *
+ * Scanner interrupt posts lines to the scan queue, the main loop decodes them
+ * to render jobs, renders jobs to the frame buffer and flushes the frame by DMA,
+ * so decode and render of the next frame go on while the previous one is sent.
+ * Both ends of this queue are in the main loop, so there are no atomics.
+ * If the queue is full then the new job is merged to the newest one,
+ * so decode never waits for render and no change is lost.
+ * Head and tail are free running counters, RENDERQ_SIZE MUST be power of 2.
+ *
+ * MIT License
+ */
+#ifndef MK52_RENDER_QUEUE_H
+#define MK52_RENDER_QUEUE_H
+
+#include <stdint.h>
+#include "vfd.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RENDERQ_SIZE 4
+#define RENDERQ_MASK (RENDERQ_SIZE - 1)
+
+/** counters of a pipeline stage, latencies in sys clocks */
+typedef struct stage_stats_s {
+	uint32_t items;   /** number of processed items */
+	uint32_t lat_max; /** the longest latency from posting an item to the end of its processing */
+	uint64_t lat_sum; /** sum of latencies */
+} stage_stats_t;
+
+static inline void stage_account(stage_stats_t *st, uint32_t latency) {
+	st->items++;
+	st->lat_sum += latency;
+	if (latency > st->lat_max)
+		st->lat_max = latency;
+}
+
+static inline uint32_t stage_lat_avg(const stage_stats_t *st) {
+	return st->items ? st->lat_sum / st->items : 0;
+}
+
+typedef struct render_job_s {
+	uint8_t  syms[NUM_DIGITS]; /** symbols or segments codes of all positions */
+	uint16_t mask;      /** positions changed since the previous job */
+	uint8_t  line_type; /** LINE_TYPE_* of the decoded line */
+	uint32_t stamp;     /** timestamp of the oldest scan line in the job */
+} render_job_t;
+
+typedef struct render_queue_s {
+	uint32_t head;     /** number of pushed jobs */
+	uint32_t tail;     /** number of rendered jobs */
+	uint32_t merged;   /** number of jobs merged to the newest one because the queue was full */
+	uint32_t max_used; /** high watermark of the queue */
+	render_job_t job[RENDERQ_SIZE];
+} render_queue_t;
+
+static inline void renderq_init(render_queue_t *q) {
+	q->head = q->tail = 0;
+	q->merged = q->max_used = 0;
+}
+
+static inline uint32_t renderq_size(render_queue_t *q) {
+	return q->head - q->tail;
+}
+
+/**
+ * push a decoded line
+ * @param syms: NUM_DIGITS symbols, copied to the job, NULL for lines without symbols to print
+ * @param mask: changed positions
+ * @param stamp: timestamp of the scan line
+ */
+static inline void renderq_push(render_queue_t *q, const uint8_t *syms, uint16_t mask,
+								uint8_t line_type, uint32_t stamp) {
+	render_job_t *job;
+	if (renderq_size(q) == RENDERQ_SIZE) {
+		/* render is behind, only the newest state matters */
+		job = &q->job[(q->head - 1) & RENDERQ_MASK];
+		mask |= job->mask;
+		stamp = job->stamp;
+		q->merged++;
+	} else {
+		job = &q->job[q->head & RENDERQ_MASK];
+		q->head++;
+		if (renderq_size(q) > q->max_used)
+			q->max_used = renderq_size(q);
+	}
+	for (uint8_t i = 0; syms && i < NUM_DIGITS; i++)
+		job->syms[i] = syms[i];
+	job->mask = mask;
+	job->line_type = line_type;
+	job->stamp = stamp;
+}
+
+/** @return the oldest job or NULL if the queue is empty */
+static inline render_job_t *renderq_peek(render_queue_t *q) {
+	if (q->head == q->tail)
+		return NULL;
+	return &q->job[q->tail & RENDERQ_MASK];
+}
+
+/* release the job obtained by renderq_peek() */
+static inline void renderq_release(render_queue_t *q) {
+	q->tail++;
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -50,7 +50,70 @@ static inline int rbuf_is_empty(ring_buf_t *rbuf) {
 }
 
 static inline int rbuf_is_full(ring_buf_t *rbuf) {
-	return (rbuf->head == ((rbuf->tail + 1) & rbuf->mask));
+	return (((rbuf->head + 1) & rbuf->mask) == rbuf->tail);
+}
+
+/* number of bytes which can be written */
+static inline uint16_t rbuf_free(ring_buf_t *rbuf) {
+	return rbuf->mask - rbuf_size(rbuf);
+}
+
+/**
+ * contiguous span of data from the tail, up to the end of the buffer,
+ * for bulk reads or DMA, rbuf_read_commit() releases it
+ * @param ptr: the first byte of the span
+ * @return number of bytes in the span
+ */
+static inline uint16_t rbuf_read_span(ring_buf_t *rbuf, uint8_t **ptr) {
+	uint32_t head = rbuf->head, tail = rbuf->tail;
+	*ptr = &rbuf->data[tail];
+	if (head >= tail)
+		return head - tail;
+	return rbuf->mask + 1 - tail;
+}
+
+static inline void rbuf_read_commit(ring_buf_t *rbuf, uint16_t len) {
+	rbuf->tail = (rbuf->tail + len) & rbuf->mask;
+}
+
+/**
+ * contiguous free span from the head, up to the end of the buffer,
+ * rbuf_write_commit() makes written bytes visible to the reader
+ * @param ptr: the first byte of the span
+ * @return number of bytes which can be written
+ */
+static inline uint16_t rbuf_write_span(ring_buf_t *rbuf, uint8_t **ptr) {
+	uint32_t head = rbuf->head, tail = rbuf->tail;
+	*ptr = &rbuf->data[head];
+	if (tail > head)
+		return tail - head - 1;
+	/* one byte is always kept free to tell full from empty */
+	return rbuf->mask + 1 - head - (tail == 0);
+}
+
+static inline void rbuf_write_commit(ring_buf_t *rbuf, uint16_t len) {
+	__atomic_signal_fence(__ATOMIC_RELEASE); /* data is stored before the head is moved */
+	rbuf->head = (rbuf->head + len) & rbuf->mask;
+}
+
+/**
+ * move the head to 'head' for bytes written without the writer APIs, as by
+ * circular DMA which does not stop when the buffer is full. If more bytes
+ * than rbuf_free() were written the oldest ones are overwritten. The tail
+ * is left to the reader, which has to skip to the head by rbuf_skip() then.
+ * @return number of overwritten bytes, 0 if none
+ */
+static inline uint16_t rbuf_write_overrun(ring_buf_t *rbuf, uint32_t head) {
+	uint32_t len = (head - rbuf->head) & rbuf->mask;
+	uint32_t free = rbuf_free(rbuf);
+
+	rbuf->head = head & rbuf->mask;
+	return (len > free) ? len - free : 0;
+}
+
+/* drop everything written so far, called by the reader */
+static inline void rbuf_skip(ring_buf_t *rbuf) {
+	rbuf->tail = rbuf->head;
 }
 
 #endif /* GENERALIO_RINGBUF_H_ */
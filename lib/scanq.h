@@ -0,0 +1,97 @@
+/**
+ * Single producer, single consumer queue of scan lines.
+ *
+ * Producer (scanner interrupt) reserves a slot, scans segments directly
+ * into it and commits it; consumer (main loop) gets a pointer to the
+ * oldest committed line and releases it when done, so no copying.
+ * Head and tail are free running counters, SCANQ_SIZE MUST be power of 2.
+ *
+ * MIT License
+ */
+#ifndef MK52_SCAN_QUEUE_H
+#define MK52_SCAN_QUEUE_H
+
+#include <stdint.h>
+#include "vfd.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SCANQ_SIZE 16
+#define SCANQ_MASK (SCANQ_SIZE - 1)
+
+typedef struct scan_queue_s {
+	uint32_t head;      /** number of committed lines, written by producer only */
+	uint32_t tail;      /** number of released lines, written by consumer only */
+	uint32_t overruns;  /** number of lines dropped because the queue was full */
+	uint32_t max_used;  /** high watermark of the queue */
+	scan_t   line[SCANQ_SIZE];
+} scan_queue_t;
+
+static inline void scanq_init(scan_queue_t *q) {
+	q->head = q->tail = 0;
+	q->overruns = q->max_used = 0;
+}
+
+static inline uint32_t scanq_size(scan_queue_t *q) {
+	return __atomic_load_n(&q->head, __ATOMIC_ACQUIRE) - __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * reserve a slot for the next line, the same slot is returned until committed
+ * @return pointer to the slot or NULL if the queue is full
+ */
+static inline scan_t *scanq_reserve(scan_queue_t *q) {
+	uint32_t tail = __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE);
+	if ((q->head - tail) >= SCANQ_SIZE)
+		return NULL;
+	return &q->line[q->head & SCANQ_MASK];
+}
+
+/* make the reserved line visible to the consumer */
+static inline void scanq_commit(scan_queue_t *q) {
+	uint32_t used = q->head + 1 - __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE);
+	if (used > q->max_used)
+		q->max_used = used;
+	__atomic_store_n(&q->head, q->head + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * get the oldest committed line without removing it from the queue
+ * @return pointer to the line or NULL if the queue is empty
+ */
+static inline scan_t *scanq_peek(scan_queue_t *q) {
+	if (__atomic_load_n(&q->head, __ATOMIC_ACQUIRE) == q->tail)
+		return NULL;
+	return &q->line[q->tail & SCANQ_MASK];
+}
+
+/**
+ * skip to the newest committed line, all older lines are released
+ * and their changes masks are merged to the newest one
+ * @param skipped: number of skipped lines
+ * @return pointer to the line or NULL if the queue is empty
+ */
+static inline scan_t *scanq_peek_latest(scan_queue_t *q, uint32_t *skipped) {
+	uint32_t head = __atomic_load_n(&q->head, __ATOMIC_ACQUIRE);
+	*skipped = 0;
+	if (head == q->tail)
+		return NULL;
+	scan_t *line = &q->line[(head - 1) & SCANQ_MASK];
+	*skipped = head - 1 - q->tail;
+	for (uint32_t tail = q->tail; tail != head - 1; tail++)
+		line->changed |= q->line[tail & SCANQ_MASK].changed;
+	__atomic_store_n(&q->tail, head - 1, __ATOMIC_RELEASE);
+	return line;
+}
+
+/* return the line obtained by scanq_peek() back to the producer */
+static inline void scanq_release(scan_queue_t *q) {
+	__atomic_store_n(&q->tail, q->tail + 1, __ATOMIC_RELEASE);
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -1,27 +1,27 @@
 /**
  * Simple handler for serial terminal (similar to getch) on STM32F10x
  */
-#include <stdio.h>
 #include <stdarg.h>
+#include <string.h>
 #include <stm32f1xx_hal.h>
 
 #include <main.h>
 #include <target.h>
+#include "dma.h"
 #include "serial.h"
 #include "ringbuf.h"
 
-/* Escape sequence states */
-#define ESC_CHAR    0
-#define ESC_BRACKET 1
-#define ESC_BRCHAR  2
-#define ESC_TILDA   3
-#define ESC_CRLF    5
-
 static UART_HandleTypeDef huart;
 static USART_TypeDef *uart;
 
+#if SERIAL_RX_DMA
+#define UART_RX_BUF_SIZE 512 /* room for output of a pasted command while the next ones are received */
+#else
 #define UART_RX_BUF_SIZE 32
-#define UART_TX_BUF_SIZE 128
+#endif
+#define UART_TX_BUF_SIZE 512 /* room for a few scan lines, see serial_log_begin() */
+
+#define UART_TX_CHUNK (UART_TX_BUF_SIZE / 2) /* max bytes per DMA transfer, so there is room to write meanwhile */
 
 static uint8_t rx_buffer[UART_RX_BUF_SIZE];
 static uint8_t tx_buffer[UART_TX_BUF_SIZE];
@@ -29,6 +29,16 @@ static uint8_t tx_buffer[UART_TX_BUF_SIZE];
 static ring_buf_t rx_rbuf;
 static ring_buf_t tx_rbuf;
 
+#if SERIAL_TX_DMA
+static volatile uint16_t tx_dma_len; /* bytes being sent by DMA, 0 if idle */
+#endif
+#if SERIAL_RX_DMA
+static volatile bool rx_overrun; /* received bytes were overwritten, the reader skips to the head */
+#endif
+
+serial_stats_t serial_stats;
+static uint32_t log_start; /* DWT counter at the beginning of the current telemetry record */
+
 /**
  * Some of HAL functions defined here for USART3, change for different USART
  */
@@ -91,9 +101,22 @@ void HAL_UART_MspInit(UART_HandleTypeDef* huart)
 	HAL_GPIO_Init(uart_uart, &uart_tx);
 	HAL_GPIO_Init(uart_uart, &uart_rx);
 
-	/* USART interrupt Init */
-	HAL_NVIC_SetPriority(uart_irq, 0, 0);
+	/* USART interrupt Init, every received byte must be read before the next one without DMA */
+	HAL_NVIC_SetPriority(uart_irq, SERIAL_RX_DMA ? 3 : 0, 0);
 	HAL_NVIC_EnableIRQ(uart_irq);
+#if SERIAL_TX_DMA || SERIAL_RX_DMA
+	__HAL_RCC_DMA1_CLK_ENABLE();
+#endif
+#if SERIAL_TX_DMA
+	/* TX transfer complete, less urgent than the scanner and the OLED flush */
+	HAL_NVIC_SetPriority(UART_TX_DMA_IRQn, 3, 0);
+	HAL_NVIC_EnableIRQ(UART_TX_DMA_IRQn);
+#endif
+#if SERIAL_RX_DMA
+	/* the same priority as the USART interrupt, both publish received bytes */
+	HAL_NVIC_SetPriority(UART_RX_DMA_IRQn, 3, 0);
+	HAL_NVIC_EnableIRQ(UART_RX_DMA_IRQn);
+#endif
 }
 
 void HAL_UART_MspDeInit(UART_HandleTypeDef* huart)
@@ -140,6 +163,53 @@ void HAL_UART_MspDeInit(UART_HandleTypeDef* huart)
 
 	HAL_GPIO_DeInit(uart_uart, uart_pins);
 	HAL_NVIC_DisableIRQ(uart_irq);
+#if SERIAL_TX_DMA
+	HAL_NVIC_DisableIRQ(UART_TX_DMA_IRQn);
+#endif
+#if SERIAL_RX_DMA
+	HAL_NVIC_DisableIRQ(UART_RX_DMA_IRQn);
+#endif
+}
+
+#if SERIAL_RX_DMA
+/**
+ * move the RX buffer head to the DMA position, so the received bytes are seen by serial_getc(),
+ * called when the line goes idle and at the half and the end of the buffer
+ */
+static void rx_dma_publish(void)
+{
+	uint32_t pos = dma_uart_rx_pos(UART_RX_BUF_SIZE) & rx_rbuf.mask;
+
+	serial_stats.rx_bytes += (pos - rx_rbuf.head) & rx_rbuf.mask;
+	/**
+	 * DMA does not stop when the buffer is full, the oldest bytes are overwritten.
+	 * The tail is written only by the reader, so it is told to skip to the head,
+	 * the buffer size is not known until then and is not counted again
+	 */
+	uint16_t lost = rbuf_write_overrun(&rx_rbuf, pos);
+	if (lost && !rx_overrun) {
+		serial_stats.rx_dropped += lost;
+		rx_overrun = true;
+	}
+}
+
+/* a half or the whole RX buffer is filled */
+void DMA1_Channel3_IRQHandler(void)
+{
+	DMA1->IFCR = UART_RX_DMA_IFCR;
+	rx_dma_publish();
+}
+#endif
+
+/* count USART receive errors, flags are cleared by the following DR read */
+static inline void rx_errors(uint32_t sr)
+{
+	if (sr & USART_SR_ORE)
+		serial_stats.rx_overruns++;
+	if (sr & USART_SR_FE)
+		serial_stats.rx_framing++;
+	if (sr & USART_SR_NE)
+		serial_stats.rx_noise++;
 }
 
 /* Very basic interrupt driven RX/TX for an UART */
@@ -153,24 +223,79 @@ void USART3_IRQHandler(void)
 {
 	uint32_t sr = uart->SR;
 
-	// ToDo: use DMA for RX to avoid loosing bytes at high speed
+	rx_errors(sr & (USART_SR_ORE | USART_SR_FE | USART_SR_NE));
+#if SERIAL_RX_DMA
+	/* bytes are read by DMA, hand the burst over when the line goes idle */
+	if (sr & USART_SR_IDLE) {
+		(void)uart->DR; /* IDLE is cleared by reading SR and then DR */
+		serial_stats.rx_bursts++;
+		rx_dma_publish();
+	}
+#else
 	if (sr & USART_SR_RXNE) {
 		uint8_t ch = uart->DR;
-		/**
-		 * at 115200 'arrow up' generates codes too fast for the interrupt
-		 * remove is_full check to cope with the speed and hope that we will not overflow :)
-		 */
-		/* if (!rbuf_is_full(&rx_rbuf)) */
+		if (!rbuf_is_full(&rx_rbuf)) {
 			rbuf_write(&rx_rbuf, ch);
+			serial_stats.rx_bytes++;
+		} else
+			serial_stats.rx_dropped++;
 		return;
 	}
+#endif
 
-	if (sr & USART_SR_TXE) {
+#if !SERIAL_TX_DMA
+	if ((sr & USART_SR_TXE) && (uart->CR1 & USART_CR1_TXEIE)) {
+		uint32_t ts = DWT->CYCCNT;
 		if (rbuf_is_empty(&tx_rbuf))
 			uart->CR1 &= ~USART_CR1_TXEIE; /* disable TX interrupt */
-		else
+		else {
 			uart->DR = rbuf_read(&tx_rbuf); /* will clear USART_SR_TXE & USART_SR_TC */
+			serial_stats.tx_bytes++;
+		}
+		serial_stats.tx_irqs++;
+		serial_stats.tx_clocks += DWT->CYCCNT - ts;
 	}
+#endif
+}
+
+#if SERIAL_TX_DMA
+/* send the next span of the TX buffer, if any, the TX DMA interrupt must not preempt it */
+static void tx_dma_next(void)
+{
+	uint8_t *data;
+	uint16_t len = rbuf_read_span(&tx_rbuf, &data);
+	if (len > UART_TX_CHUNK)
+		len = UART_TX_CHUNK;
+	tx_dma_len = len;
+	if (len)
+		dma_uart_tx_start(uart, data, len);
+}
+
+/* TX chunk is written to USART, release it and start the next one */
+void DMA1_Channel2_IRQHandler(void)
+{
+	uint32_t ts = DWT->CYCCNT;
+	dma_uart_tx_stop(uart);
+	rbuf_read_commit(&tx_rbuf, tx_dma_len);
+	serial_stats.tx_bytes += tx_dma_len;
+	tx_dma_next();
+	serial_stats.tx_irqs++;
+	serial_stats.tx_clocks += DWT->CYCCNT - ts;
+}
+#endif
+
+/* start sending the TX buffer if the transmitter is idle */
+static void tx_start(void)
+{
+#if SERIAL_TX_DMA
+	NVIC_DisableIRQ(UART_TX_DMA_IRQn);
+	if (!tx_dma_len)
+		tx_dma_next();
+	NVIC_EnableIRQ(UART_TX_DMA_IRQn);
+#else
+	/* enable TX interrupt to start transmit */
+	uart->CR1 |= USART_CR1_TXEIE;
+#endif
 }
 
 int serial_init(uint32_t baud)
@@ -196,11 +321,46 @@ int serial_init(uint32_t baud)
 	huart.Init.OverSampling = UART_OVERSAMPLING_16;
 
 	HAL_UART_Init(&huart);
+#if SERIAL_RX_DMA
+	dma_uart_rx_start(uart, rx_buffer, UART_RX_BUF_SIZE);
+	/* idle line and receive error interrupts */
+	uart->CR1 |= USART_CR1_IDLEIE;
+	uart->CR3 |= USART_CR3_EIE;
+#else
 	/* enable RX interrupt */
 	uart->CR1 |= USART_CR1_RXNEIE;
+#endif
+	serial_stats_reset();
 	return 0;
 }
 
+void serial_set_baud(uint32_t baud)
+{
+	/* let the last byte out with the old rate */
+	while (serial_is_sending());
+	while (!(uart->SR & USART_SR_TC));
+	huart.Init.BaudRate = baud;
+	uart->CR1 &= ~USART_CR1_UE;
+#if (USART_TO_USE == 1)
+	uart->BRR = UART_BRR_SAMPLING16(HAL_RCC_GetPCLK2Freq(), baud);
+#else
+	uart->BRR = UART_BRR_SAMPLING16(HAL_RCC_GetPCLK1Freq(), baud);
+#endif
+	uart->CR1 |= USART_CR1_UE;
+	serial_stats_reset();
+}
+
+uint32_t serial_get_baud(void)
+{
+	return huart.Init.BaudRate;
+}
+
+void serial_stats_reset(void)
+{
+	memset(&serial_stats, 0, sizeof(serial_stats));
+	serial_stats.start = millis();
+}
+
 static inline uint16_t _serial_getc(void)
 {
 	uint16_t ch = 0xFF00;
@@ -216,89 +376,229 @@ int serial_is_sending(void)
 
 uint16_t serial_getc(void)
 {
-	static uint8_t esc = ESC_CHAR;
-	static uint8_t idx = 0;
+	static esc_seq_t esc;
 	uint16_t ch;
 
-	ch = _serial_getc();
-	if (ch & 0xFF00)
-		return 0;
-
-	/* ESC sequence state machine */
-	if (ch == 27) {
-		esc = ESC_BRACKET;
-		return 0;
-	}
-	if (esc == ESC_BRACKET) {
-		if (ch == '[') {
-			esc = ESC_BRCHAR;
-			return 0;
-		}
+#if SERIAL_RX_DMA
+	if (rx_overrun) {
+		/* bytes left are out of order, drop them and a sequence in progress, the CLI resyncs at the next line end */
+		rx_overrun = false;
+		rbuf_skip(&rx_rbuf);
+		esc = (esc_seq_t){ 0 };
+		serial_stats.rx_skips++;
 	}
-	if (esc == ESC_BRCHAR) {
-		esc = ESC_CHAR;
-		if (ch >= 'A' && ch <= 'D') {
-			ch |= EXTRA_KEY;
-			return ch;
-		}
-		if ((ch >= '1') && (ch <= '6')) {
-			esc = ESC_TILDA;
-			idx = ch - '0';
-			return 0;
-		}
-		return ch;
-	}
-	if (esc == ESC_TILDA) {
-		esc = ESC_CHAR;
-		if (ch == '~') {
-			ch = EXTRA_KEY | idx;
+#endif
+	/* bytes of a burst are decoded one by one, a sequence can be split between bursts */
+	while (!((ch = _serial_getc()) & 0xFF00)) {
+		ch = esc_seq_decode(&esc, ch);
+		if (ch)
 			return ch;
-		}
-		return 0;
 	}
+	return 0;
+}
 
-	/* convert CR to LF */
-	if (ch == '\r') {
-		esc = ESC_CRLF;
-		return '\n';
-	}
-	/* do not return LF if it is part of CR+LF combination */
-	if (ch == '\n') {
-		if (esc == ESC_CRLF) {
-			esc = ESC_CHAR;
-			return 0;
-		}
-	}
-	esc = ESC_CHAR;
-	return ch;
+/* wait for room in the TX buffer, the main loop is stalled meanwhile */
+static void tx_wait(void)
+{
+	uint32_t ts = DWT->CYCCNT;
+	while (rbuf_is_full(&tx_rbuf))
+		tx_start();
+	ts = DWT->CYCCNT - ts;
+	serial_stats.tx_stalls++;
+	serial_stats.tx_stall_clocks += ts;
+	if (ts > serial_stats.tx_stall_max)
+		serial_stats.tx_stall_max = ts;
 }
 
 /* will block if TX buffer is full */
 void serial_putc(uint8_t ch)
 {
-	while (rbuf_is_full(&tx_rbuf));
+	if (rbuf_is_full(&tx_rbuf))
+		tx_wait();
 	rbuf_write(&tx_rbuf, ch);
-	/* enable TX interrupt to start transmit */
-	uart->CR1 |= USART_CR1_TXEIE;
+	tx_start();
+}
+
+void serial_write(const void *buf, uint32_t len)
+{
+	const uint8_t *src = buf;
+
+	while (len) {
+		uint8_t *dst;
+		uint16_t span = rbuf_write_span(&tx_rbuf, &dst);
+		if (!span) { /* full, wait for the transmitter */
+			tx_wait();
+			continue;
+		}
+		if (span > len)
+			span = len;
+		memcpy(dst, src, span);
+		rbuf_write_commit(&tx_rbuf, span);
+		src += span;
+		len -= span;
+	}
+	tx_start();
 }
 
 void serial_puts(const char *str)
 {
-	for(unsigned i = 0; str[i]; i++) {
-		if (str[i] == '\n')
-			serial_putc('\r');
-		serial_putc(str[i]);
+	while (*str) {
+		/* text up to the line end is copied as it is */
+		size_t len = strcspn(str, "\n");
+		serial_write(str, len);
+		str += len;
+		if (*str == '\n') {
+			serial_write("\r\n", 2);
+			str++;
+		}
+	}
+}
+
+bool serial_log_begin(uint32_t len)
+{
+	/* only the main loop writes, so the room can only grow while the record is written */
+	if (rbuf_free(&tx_rbuf) < len) {
+		serial_stats.log_dropped++;
+		return false;
 	}
+	serial_stats.log_records++;
+	log_start = DWT->CYCCNT;
+	return true;
+}
+
+void serial_log_end(void)
+{
+	serial_stats.log_clocks += DWT->CYCCNT - log_start;
+}
+
+/* 'n' copies of 'ch', a space or a zero, written in chunks to start the transmitter once per chunk */
+static void put_pad(char ch, int16_t n)
+{
+	static const char spaces[16] = "                ";
+	static const char zeros[16] = "0000000000000000";
+	const char *pad = (ch == '0') ? zeros : spaces;
+
+	while (n > 0) {
+		uint8_t len = (n > (int16_t)sizeof(spaces)) ? sizeof(spaces) : n;
+		serial_write(pad, len);
+		n -= len;
+	}
+}
+
+/**
+ * print a number, digits are made from the end of a small buffer
+ * @param base: 10 or 16
+ * @param upper: 'A' for upper case hex digits, 'a' for lower case
+ * @param width: minimal number of characters, padded by 'pad' from the left or by spaces from the right
+ */
+static void put_num(uint32_t val, bool neg, uint8_t base, char upper, uint8_t width, char pad, bool left)
+{
+	char digits[10];
+	uint8_t len = 0;
+
+	do {
+		uint8_t d = val % base;
+		digits[sizeof(digits) - 1 - len++] = (d < 10) ? d + '0' : d - 10 + upper;
+		val /= base;
+	} while (val);
+
+	int16_t fill = width - len - neg;
+	if (!left && pad == ' ')
+		put_pad(' ', fill);
+	if (neg)
+		serial_putc('-');
+	if (!left && pad == '0')
+		put_pad('0', fill);
+	serial_write(&digits[sizeof(digits) - len], len);
+	if (left)
+		put_pad(' ', fill);
 }
 
+void serial_putu(uint32_t val)
+{
+	put_num(val, false, 10, 'A', 0, ' ', false);
+}
+
+/**
+ * formatting without an intermediate buffer, only what this firmware prints:
+ * %[-][0][width][l|h]{u|d|i|x|X|s|c|%}, int and long are the same size
+ */
 void serial_print(const char *format, ...)
 {
-	char buffer[UART_TX_BUF_SIZE];
+	const char *fmt = format;
 	va_list args;
 	va_start(args, format);
-	vsprintf(buffer, format, args);
 
-	serial_puts(buffer);
+	while (*fmt) {
+		/* text up to the next conversion or line end is copied as it is */
+		size_t len = strcspn(fmt, "%\n");
+		if (len) {
+			serial_write(fmt, len);
+			fmt += len;
+			continue;
+		}
+		if (*fmt++ == '\n') {
+			serial_write("\r\n", 2);
+			continue;
+		}
+
+		const char *spec = fmt - 1;
+		bool left = false;
+		char pad = ' ';
+		uint8_t width = 0;
+		if (*fmt == '-') {
+			left = true;
+			fmt++;
+		}
+		if (*fmt == '0') {
+			pad = '0';
+			fmt++;
+		}
+		while (*fmt >= '0' && *fmt <= '9')
+			width = width * 10 + (*fmt++ - '0');
+		while (*fmt == 'l' || *fmt == 'h')
+			fmt++;
+
+		switch (*fmt) {
+		case 'u':
+			put_num(va_arg(args, unsigned), false, 10, 'A', width, pad, left);
+			break;
+		case 'd':
+		case 'i': {
+			int val = va_arg(args, int);
+			put_num((val < 0) ? -(unsigned)val : (unsigned)val, val < 0, 10, 'A', width, pad, left);
+			break;
+		}
+		case 'x':
+		case 'X':
+			put_num(va_arg(args, unsigned), false, 16, (*fmt == 'x') ? 'a' : 'A', width, pad, left);
+			break;
+		case 's': {
+			const char *str = va_arg(args, const char *);
+			int16_t fill = width - strlen(str);
+			if (!left)
+				put_pad(' ', fill);
+			serial_puts(str);
+			if (left)
+				put_pad(' ', fill);
+			break;
+		}
+		case 'c':
+			serial_putc(va_arg(args, int));
+			break;
+		case '%':
+			serial_putc('%');
+			break;
+		default: /* not supported, the whole specification is printed as it is */
+			if (!*fmt || *fmt == '\n') {
+				serial_write(spec, fmt - spec);
+				continue;
+			}
+			serial_write(spec, fmt + 1 - spec);
+			break;
+		}
+		fmt++;
+	}
 
 	va_end(args);
 }
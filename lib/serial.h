@@ -6,27 +6,14 @@
 #define SERIAL_CHAR_H
 
 #include <stdint.h>
+#include <stdbool.h>
+#include "target.h"
+#include "escseq.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-/** non-character flag */
-#define EXTRA_KEY   0x0100
-
-/** support for arrow keys for very simple one command deep history */
-#define ARROW_UP    0x0141
-#define ARROW_DOWN  0x0142
-#define ARROW_RIGHT 0x0143
-#define ARROW_LEFT  0x0144
-
-#define KEY_HOME    0x0101
-#define KEY_INS	    0x0102
-#define KEY_DEL	    0x0103
-#define KEY_END	    0x0104
-#define KEY_PGUP    0x0105
-#define KEY_PGDN    0x0106
-
 #define	UART_BR_2400	2400
 #define UART_BR_4800	4800
 #define UART_BR_9600 	9600
@@ -34,18 +21,79 @@ extern "C" {
 #define UART_BR_38400 	38400
 #define UART_BR_57600 	57600
 #define UART_BR_115200 	115200
+#define UART_BR_230400 	230400
+#define UART_BR_460800 	460800
+#define UART_BR_921600 	921600
+
+/**
+ * send TX buffer by DMA in contiguous spans, one interrupt per chunk instead of
+ * one per byte; DMA channels of USART1 and USART2 are used by the OLED flush
+ * and the scanner, so only USART3 can use it
+ */
+#define SERIAL_TX_DMA (USART_TO_USE == 3)
+/**
+ * receive by circular DMA, received bursts are handed to serial_getc() when
+ * the line goes idle or a half of the buffer is filled, only USART3 as above
+ */
+#define SERIAL_RX_DMA (USART_TO_USE == 3)
 
 
 int serial_init(uint32_t baud);
+/* change baud rate when all queued output is sent */
+void serial_set_baud(uint32_t baud);
+uint32_t serial_get_baud(void);
 uint16_t serial_getc(void);
 void serial_putc(uint8_t ch);
+/* copy bytes to the TX buffer as they are, will block if the buffer is full */
+void serial_write(const void *buf, uint32_t len);
 void serial_puts(const char *str);
-void serial_print(const char *format, ...);
+/**
+ * printf-like output straight to the TX buffer, see serial_print() for supported conversions;
+ * arguments are checked against the format, uint32_t is long on ARM and is cast to unsigned
+ */
+void serial_print(const char *format, ...) __attribute__((format(printf, 1, 2)));
+void serial_putu(uint32_t val); /** print val in decimal format */
 void serial_putb(uint32_t val, uint8_t len); /** print val in binary format */
 void serial_puth(uint8_t val);				 /** print uint8_t in hex format */
 
 int serial_is_sending(void);
 
+/**
+ * non-blocking output of telemetry records, such as scan lines, which must not stall
+ * the main loop: a record is written only if the TX buffer has room for all of it,
+ * otherwise it is dropped whole and counted; other output waits for the transmitter
+ * @param len: the longest length of the record, with CR of every LF
+ * @return true if the record is to be written by serial_p*() calls
+ */
+bool serial_log_begin(uint32_t len);
+/* the record admitted by serial_log_begin() is written, its time is accounted */
+void serial_log_end(void);
+
+/* serial port counters since the last serial_stats_reset() */
+typedef struct serial_stats_s {
+	uint32_t start;     /** millis() of the reset */
+	uint32_t tx_bytes;  /** bytes sent */
+	uint32_t tx_irqs;   /** TX interrupts: one per DMA chunk, or one per byte without DMA */
+	uint32_t tx_clocks; /** sys clocks spent in TX interrupts */
+	uint32_t rx_bytes;  /** bytes received */
+	uint32_t rx_bursts; /** idle line events */
+	uint32_t rx_dropped; /** bytes lost because RX buffer was full */
+	uint32_t rx_skips;   /** RX buffer contents dropped after bytes were overwritten by DMA */
+	uint32_t rx_overruns; /** USART overrun errors */
+	uint32_t rx_framing;  /** USART framing errors */
+	uint32_t rx_noise;    /** USART noise errors */
+	uint32_t tx_stalls;       /** waits for room in the TX buffer */
+	uint32_t tx_stall_clocks; /** sys clocks spent waiting */
+	uint32_t tx_stall_max;    /** the longest wait */
+	uint32_t log_records; /** telemetry records written */
+	uint32_t log_dropped; /** telemetry records dropped because TX buffer was full */
+	uint32_t log_clocks;  /** sys clocks spent writing records */
+} serial_stats_t;
+
+extern serial_stats_t serial_stats;
+
+void serial_stats_reset(void);
+
 #ifdef __cplusplus
 }
 #endif
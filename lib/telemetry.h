@@ -0,0 +1,134 @@
+/**
+ * Binary telemetry of scan lines, an alternative to the text scan output.
+ *
+ * Every scanned line is sent as a record with only the positions changed since
+ * the previous sent record, so a record is a few bytes instead of a text line:
+ *   seq       uint8   incremented for every record, gaps are dropped records
+ *   type      uint8   LINE_TYPE_* of the line and TLM_* flags
+ *   stamp     uint32  millis() of the line
+ *   mask      uint16  changed positions, bit 0 is the first scan position
+ *   segs      uint8[] segments codes of changed positions, in order of positions
+ *   skipped   uint32  lines skipped by coalescing, if TLM_SKIPPED
+ *   cycles    uint16  blank scan cycles before this line, if TLM_BLANK
+ *   blank     uint32  usec of the blank cycles, if TLM_BLANK
+ *   crc       uint16  CRC-16/CCITT-FALSE of all the above
+ * Multi-byte fields are little endian. The record is COBS encoded and framed
+ * by zero bytes on both sides, so text output of CLI between frames is kept
+ * apart and a receiver synchronizes on the next zero byte.
+ * tools/mk52tlm.py decodes frames back to the text scan output.
+ *
+ * Does not depend on HAL or any STM32 peripherals, so it can be built
+ * for a host.
+ *
+ * MIT License
+ */
+#ifndef MK52_TELEMETRY_H
+#define MK52_TELEMETRY_H
+
+#include <stdint.h>
+#include "vfd.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TLM_SKIPPED 0x01 /** skipped field is present */
+#define TLM_BLANK   0x02 /** cycles and blank fields are present */
+#define TLM_HEX     0x04 /** print hex scan codes, as set by "print hex" */
+
+#define TLM_ALL_POS ((1u << NUM_SCAN_POS) - 1)
+
+/** the longest record and the longest frame: COBS overhead and two zero bytes */
+#define TLM_RECORD_MAX (8 + NUM_SCAN_POS + 4 + 6 + 2)
+#define TLM_FRAME_MAX  (TLM_RECORD_MAX + TLM_RECORD_MAX / 254 + 1 + 2)
+
+typedef struct tlm_event_s {
+	uint8_t  type;    /** LINE_TYPE_* and TLM_* flags */
+	uint32_t stamp;   /** millis() */
+	uint16_t mask;    /** positions to send */
+	const uint8_t *scan; /** NUM_SCAN_POS segments codes */
+	uint32_t skipped; /** if TLM_SKIPPED */
+	uint16_t cycles;  /** if TLM_BLANK */
+	uint32_t blank;   /** if TLM_BLANK */
+} tlm_event_t;
+
+static inline uint16_t tlm_crc16(const uint8_t *data, uint16_t len) {
+	uint16_t crc = 0xFFFF;
+	while (len--) {
+		crc ^= (uint16_t)*data++ << 8;
+		for (uint8_t i = 0; i < 8; i++)
+			crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+	}
+	return crc;
+}
+
+static inline uint8_t *tlm_put16(uint8_t *dst, uint16_t val) {
+	*dst++ = val;
+	*dst++ = val >> 8;
+	return dst;
+}
+
+static inline uint8_t *tlm_put32(uint8_t *dst, uint32_t val) {
+	dst = tlm_put16(dst, val);
+	return tlm_put16(dst, val >> 16);
+}
+
+/**
+ * COBS encoding: every zero byte is replaced by the distance to the next one
+ * @param dst: at least len + len / 254 + 1 bytes
+ * @return encoded length, without zero bytes
+ */
+static inline uint16_t tlm_cobs_encode(const uint8_t *src, uint16_t len, uint8_t *dst) {
+	uint8_t *code = dst++; /* place of the distance to the next zero */
+	uint8_t *start = dst - 1;
+	uint8_t dist = 1;
+
+	while (len--) {
+		uint8_t byte = *src++;
+		if (byte) {
+			*dst++ = byte;
+			dist++;
+		}
+		if (!byte || dist == 0xFF) {
+			*code = dist;
+			code = dst++;
+			dist = 1;
+		}
+	}
+	*code = dist;
+	return dst - start;
+}
+
+/**
+ * make a frame of an event
+ * @param frame: TLM_FRAME_MAX bytes
+ * @return frame length, with zero bytes
+ */
+static inline uint16_t tlm_frame(uint8_t *frame, uint8_t seq, const tlm_event_t *ev) {
+	uint8_t rec[TLM_RECORD_MAX];
+	uint8_t *dst = rec;
+
+	*dst++ = seq;
+	*dst++ = ev->type;
+	dst = tlm_put32(dst, ev->stamp);
+	dst = tlm_put16(dst, ev->mask);
+	for (uint16_t bits = ev->mask; bits; bits &= bits - 1)
+		*dst++ = ev->scan[__builtin_ctz(bits)];
+	if (ev->type & TLM_SKIPPED)
+		dst = tlm_put32(dst, ev->skipped);
+	if (ev->type & TLM_BLANK) {
+		dst = tlm_put16(dst, ev->cycles);
+		dst = tlm_put32(dst, ev->blank);
+	}
+	dst = tlm_put16(dst, tlm_crc16(rec, dst - rec));
+
+	frame[0] = 0;
+	uint16_t len = tlm_cobs_encode(rec, dst - rec, &frame[1]) + 1;
+	frame[len++] = 0;
+	return len;
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,127 @@
+/**
+ * Terminal input received in bursts, as by the circular RX DMA: escape
+ * sequences split at every point between bursts decode to the same keys,
+ * and after an overrun of the ring buffer the reader skips to the head
+ * and reads the following bytes in order.
+ *
+ * MIT License
+ */
+#include <stdbool.h>
+#include <string.h>
+
+#include "test.h"
+#include "escseq.h"
+#include "ringbuf.h"
+
+#define RX_SIZE 32
+
+static uint8_t rx_buffer[RX_SIZE];
+static ring_buf_t rx;
+static uint32_t dma_pos; /* bytes written by the simulated DMA */
+
+static const char input[] = "ab\x1b[A\x1b[3~\r\nx\x1b[B\r\x1b[5~\n\x1b[C\x1b[D\x1b[1~\x1b[4~\x1bq\x1b[6~\r";
+static const uint16_t keys[] = {
+	'a', 'b', ARROW_UP, KEY_DEL, '\n', 'x', ARROW_DOWN, '\n', KEY_PGUP, '\n',
+	ARROW_RIGHT, ARROW_LEFT, KEY_HOME, KEY_END, 'q', KEY_PGDN, '\n',
+};
+
+/* write bytes as the DMA does and publish them as the RX interrupt does */
+static uint32_t dma_burst(const uint8_t *data, uint32_t len)
+{
+	for (uint32_t i = 0; i < len; i++)
+		rx_buffer[dma_pos++ & rx.mask] = data[i];
+	return rbuf_write_overrun(&rx, dma_pos);
+}
+
+/* serial_getc(): decode everything received so far */
+static uint32_t drain(esc_seq_t *esc, uint16_t *out)
+{
+	uint32_t n = 0;
+	while (!rbuf_is_empty(&rx)) {
+		uint16_t ch = esc_seq_decode(esc, rbuf_read(&rx));
+		if (ch)
+			out[n++] = ch;
+	}
+	return n;
+}
+
+static void test_split(void)
+{
+	const uint32_t len = sizeof(input) - 1;
+	const uint32_t num = sizeof(keys) / sizeof(keys[0]);
+	uint32_t bad = 0;
+
+	/* bursts of every size, so every byte boundary is a split point of a sequence */
+	for (uint32_t burst = 1; burst < RX_SIZE; burst++) {
+		for (uint32_t first = 1; first <= burst; first++) {
+			esc_seq_t esc = {0};
+			uint16_t out[64];
+			uint32_t n = 0;
+			rbuf_init(&rx, rx_buffer, RX_SIZE);
+			dma_pos = 0;
+			for (uint32_t i = 0; i < len;) {
+				uint32_t chunk = (i == 0) ? first : burst;
+				if (chunk > len - i)
+					chunk = len - i;
+				CHECK(!dma_burst((const uint8_t *)&input[i], chunk));
+				i += chunk;
+				n += drain(&esc, &out[n]);
+			}
+			if (n != num || memcmp(out, keys, sizeof(keys)))
+				bad++;
+			CHECK(esc.state != ESC_BRACKET && esc.state != ESC_BRCHAR && esc.state != ESC_TILDA);
+		}
+	}
+	CHECK(!bad);
+}
+
+static void test_overrun(void)
+{
+	uint8_t data[RX_SIZE * 2];
+	uint32_t rnd = 17, sent = 0, received = 0, overwritten = 0, skips = 0, disorder = 0;
+	uint8_t expect = 0;
+	bool overrun = false;
+
+	rbuf_init(&rx, rx_buffer, RX_SIZE);
+	dma_pos = 0;
+	for (uint32_t iter = 0; iter < 100000; iter++) {
+		/* less than a whole buffer per interrupt, as the half transfer interrupt guarantees */
+		uint32_t len = test_rand(&rnd) % RX_SIZE;
+		for (uint32_t i = 0; i < len; i++)
+			data[i] = sent + i;
+		uint32_t lost = dma_burst(data, len);
+		sent += len;
+		/* the interrupt only flags the overrun, the tail is written by the reader alone */
+		if (lost && !overrun) {
+			overwritten += lost;
+			overrun = true;
+		}
+
+		/* serial_getc(): skip to the head, the next byte is the next one received */
+		if (overrun) {
+			overrun = false;
+			rbuf_skip(&rx);
+			expect = sent;
+			skips++;
+		}
+		CHECK(rbuf_size(&rx) <= rx.mask);
+		/* the reader falls behind now and then */
+		uint32_t reads = test_rand(&rnd) % (RX_SIZE / 2);
+		while (reads-- && !rbuf_is_empty(&rx)) {
+			if (rbuf_read(&rx) != expect++)
+				disorder++;
+			received++;
+		}
+	}
+	printf("%u bytes sent, %u received, %u overwritten, %u skips\n", sent, received, overwritten, skips);
+	CHECK(skips);
+	CHECK(!disorder);
+	CHECK(received + overwritten <= sent);
+}
+
+int main(void)
+{
+	test_split();
+	test_overrun();
+	return test_failed;
+}
@@ -0,0 +1,144 @@
+/**
+ * Phase-locked scan scheduler driven by a simulated grid: the grid 8 edge
+ * comes every scan cycle with jitter and slow drift of the period, samples
+ * are taken by a simulated timer with start and interrupt latencies.
+ * Sampling points are compared with the middles of the real grid windows,
+ * for the interrupt per sample path and for the DMA path with a fixed timer step.
+ *
+ * MIT License
+ */
+#include <math.h>
+#include <stdlib.h>
+
+#include "test.h"
+#include "vfd.h"
+
+#define CYCLE     136080.0 /* sys clocks of a scan cycle at 72 MHz, 1.89 msec */
+#define CYCLES    4000
+#define SETTLE    200      /* cycles to lock and learn the latency before checking */
+#define TIM_START 35       /* clocks from the delay calculation to the timer start */
+#define ISR_ENTRY 12       /* clocks from the timer update to the interrupt handler */
+
+typedef struct sim_s {
+	uint32_t rnd;
+	double   edge;    /* the current grid 8 edge */
+	double   period;  /* the current real cycle period */
+	double   err_max; /* the largest distance of a sample from the window middle, after SETTLE */
+	double   err_sum;
+	uint32_t err_num;
+} sim_t;
+
+/* the next edge: the period drifts within 1% back and forth, as with temperature, and edges jitter */
+static uint32_t sim_edge(sim_t *sim, uint32_t cycle)
+{
+	sim->period = CYCLE * (1.0 + 0.01 * sin(cycle * 0.002));
+	sim->edge += sim->period;
+	return (uint32_t)sim->edge + test_rand(&sim->rnd) % 16;
+}
+
+/* account a sample against the middle of its window */
+static void sim_sample(sim_t *sim, uint32_t cycle, uint8_t idx, uint8_t sub, uint8_t num, uint32_t ts)
+{
+	double mid = sim->edge + sim->period * (idx + (2 * sub + 1) / (2.0 * num)) / NUM_SCAN_POS;
+	double err = fabs((double)(int32_t)(ts - (uint32_t)mid) - (mid - floor(mid)));
+
+	if (cycle < SETTLE)
+		return;
+	if (err > sim->err_max)
+		sim->err_max = err;
+	sim->err_sum += err;
+	sim->err_num++;
+}
+
+static void report(const char *name, sim_t *sim, vfd_pll_t *pll, uint8_t num)
+{
+	double window = CYCLE / NUM_SCAN_POS / num;
+	printf("%-22s x%u: max %6.1f clocks (%5.2f%% of a sample window), avg %5.1f, latency %d\n", name, num,
+		   sim->err_max, sim->err_max * 100 / window, sim->err_sum / sim->err_num, pll->latency >> VFD_PLL_FRAC);
+}
+
+/**
+ * a timer interrupt per sample, every sample is timestamped and scheduled from the PLL
+ * @return the largest error, made by the edge jitter and the period filter only
+ */
+static double test_irq(void)
+{
+	sim_t sim = {.rnd = 5, .edge = 1000};
+	vfd_pll_t pll;
+	vfd_pll_init(&pll, CYCLE / 2);
+
+	for (uint32_t c = 0; c < CYCLES; c++) {
+		uint32_t edge = sim_edge(&sim, c);
+		if (!vfd_pll_start(&pll, edge))
+			continue;
+		uint32_t now = edge + 40;
+		for (uint8_t idx = 0; idx < NUM_SCAN_POS; idx++) {
+			uint32_t target = vfd_pll_target(&pll, idx, 0, 1);
+			uint32_t ts = now + TIM_START + vfd_pll_delay(&pll, target, now) + ISR_ENTRY + test_rand(&sim.rnd) % 4;
+			sim_sample(&sim, c, idx, 0, 1, ts);
+			vfd_pll_sample(&pll, target, ts);
+			now = ts + 80;
+		}
+	}
+	report("interrupt per sample", &sim, &pll, 1);
+	CHECK(sim.err_max < 50);
+	/* the timer start and the interrupt entry are learned */
+	CHECK(abs((pll.latency >> VFD_PLL_FRAC) - (TIM_START + ISR_ENTRY)) <= 3);
+	return sim.err_max;
+}
+
+/**
+ * TIM4 steps by DMA, only the last sample is seen by the transfer complete interrupt
+ * @param rounded: true for vfd_pll_step(), false for the truncated window step
+ * @param irq_max: the largest error of the interrupt per sample path
+ * @return average error
+ */
+static double test_dma(uint8_t num, bool rounded, double irq_max)
+{
+	sim_t sim = {.rnd = 9, .edge = 1000};
+	vfd_pll_t pll;
+	vfd_pll_init(&pll, CYCLE / 2);
+	uint8_t samples = NUM_SCAN_POS * num;
+
+	for (uint32_t c = 0; c < CYCLES; c++) {
+		uint32_t edge = sim_edge(&sim, c);
+		if (!vfd_pll_start(&pll, edge))
+			continue;
+		uint32_t now = edge + 40;
+		uint32_t step, first;
+		if (rounded)
+			step = vfd_pll_step(&pll, num, &first);
+		else {
+			step = (pll.window / num) >> VFD_PLL_FRAC;
+			first = vfd_pll_target(&pll, 0, 0, num);
+		}
+		uint32_t update = now + TIM_START + vfd_pll_delay(&pll, first, now);
+		for (uint8_t k = 0; k < samples; k++, update += step)
+			sim_sample(&sim, c, k / num, k % num, num, update);
+		update -= step;
+
+		uint32_t target = vfd_pll_target(&pll, NUM_SCAN_POS - 1, num - 1, num);
+		int32_t err = vfd_pll_error(&pll, target, update);
+		if (rounded)
+			vfd_pll_learn(&pll, err - (int32_t)(first + (samples - 1) * step - target));
+	}
+	report(rounded ? "DMA, centered step" : "DMA, truncated step", &sim, &pll, num);
+	if (rounded) {
+		/* only the centered rounding error of the step is added */
+		CHECK(sim.err_max < irq_max + (samples - 1) / 4.0 + 4);
+		/* the start latency is learned */
+		CHECK(abs((pll.latency >> VFD_PLL_FRAC) - TIM_START) <= 2);
+	}
+	return sim.err_sum / sim.err_num;
+}
+
+int main(void)
+{
+	double irq_max = test_irq();
+	for (uint8_t num = 1; num <= VFD_VOTE_MAX; num += 2) {
+		double before = test_dma(num, false, irq_max);
+		double after = test_dma(num, true, irq_max);
+		CHECK(after <= before);
+	}
+	return test_failed;
+}
@@ -0,0 +1,176 @@
+/**
+ * 4 bpp raster: fills and blits against a pixel by pixel reference on random
+ * rectangles with clipping, a golden image of a known drawing, and timing
+ * against pixel by pixel drawing.
+ *
+ * MIT License
+ */
+#include <string.h>
+
+#include "test.h"
+#include "raster.h"
+
+#define WIDTH  256
+#define HEIGHT 64
+#define STRIDE (WIDTH / 2)
+
+static uint8_t buf[STRIDE * HEIGHT] __attribute__((aligned(4)));
+static uint8_t ref_buf[STRIDE * HEIGHT] __attribute__((aligned(4)));
+static const raster_t raster = { buf, STRIDE, WIDTH, HEIGHT };
+static const raster_t ref = { ref_buf, STRIDE, WIDTH, HEIGHT };
+
+static void ref_fill_rect(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t color)
+{
+	for (int16_t j = y; j < y + h; j++)
+		for (int16_t i = x; i < x + w; i++)
+			raster_set_pixel(&ref, i, j, color);
+}
+
+static uint8_t image_pixel(const uint8_t *src, uint16_t stride, int16_t x, int16_t y)
+{
+	uint8_t data = src[y * stride + x / 2];
+	return (x & 1) ? (data & 0x0F) : (data >> 4);
+}
+
+static void ref_blit(int16_t x, int16_t y, const uint8_t *src, uint16_t stride, int16_t w, int16_t h)
+{
+	for (int16_t j = 0; j < h; j++)
+		for (int16_t i = 0; i < w; i++)
+			raster_set_pixel(&ref, x + i, y + j, image_pixel(src, stride, i, j));
+}
+
+static void test_random(void)
+{
+	uint8_t image[32 * 40];
+	uint32_t rnd = 11, mismatches = 0;
+
+	for (uint32_t i = 0; i < sizeof(image); i++)
+		image[i] = test_rand(&rnd);
+	memset(buf, 0x5A, sizeof(buf));
+	memset(ref_buf, 0x5A, sizeof(ref_buf));
+
+	for (uint32_t iter = 0; iter < 20000; iter++) {
+		/* positions and sizes reach outside of the raster to exercise clipping */
+		int16_t x = (int16_t)(test_rand(&rnd) % (WIDTH + 80)) - 40;
+		int16_t y = (int16_t)(test_rand(&rnd) % (HEIGHT + 40)) - 20;
+		int16_t w = test_rand(&rnd) % 64;
+		int16_t h = test_rand(&rnd) % 40;
+		uint8_t color = test_rand(&rnd) & 0x0F;
+		switch (iter % 4) {
+		case 0:
+			raster_fill_rect(&raster, x, y, w, h, color);
+			ref_fill_rect(x, y, w, h, color);
+			break;
+		case 1:
+			raster_hline(&raster, x, y, w, color);
+			ref_fill_rect(x, y, w, 1, color);
+			raster_vline(&raster, x, y, h, color);
+			ref_fill_rect(x, y, 1, h, color);
+			break;
+		default: {
+			/* the source starts at an odd or even pixel of the image */
+			uint8_t sx = test_rand(&rnd) % 2;
+			if (w > 63 - sx)
+				w = 63 - sx;
+			raster_blit(&raster, x, y, image + sx / 2, 32, w, h);
+			if (sx) {
+				/* the odd start is made by clipping a blit from one pixel to the left */
+				raster_blit(&raster, x - 1, y, image, 32, w + 1, h);
+				ref_blit(x - 1, y, image, 32, w + 1, h);
+			} else
+				ref_blit(x, y, image, 32, w, h);
+			break;
+		}
+		}
+		if (memcmp(buf, ref_buf, sizeof(buf))) {
+			mismatches++;
+			memcpy(buf, ref_buf, sizeof(buf));
+		}
+	}
+	CHECK(!mismatches);
+	for (int16_t y = 0; y < HEIGHT; y++)
+		for (int16_t x = 0; x < WIDTH; x++)
+			CHECK(raster_get_pixel(&raster, x, y) == raster_get_pixel(&ref, x, y));
+	CHECK(raster_get_pixel(&raster, -1, 0) == 0 && raster_get_pixel(&raster, WIDTH, 0) == 0);
+}
+
+/* a drawing of a few primitives on a 16x6 raster, as hex rows */
+static void test_golden(void)
+{
+	static const char *golden[] = {
+		"0000000000000000",
+		"0FFFFF0000000000",
+		"0F0000F123000000",
+		"0F000004567000A0",
+		"0FFFFF089AB000A0",
+		"0000000CDEF00000",
+	};
+	static const uint8_t image[] = { 0x12, 0x30, 0x45, 0x67, 0x89, 0xAB, 0xCD, 0xEF };
+	uint8_t small[8 * 6] __attribute__((aligned(4)));
+	const raster_t r = { small, 8, 16, 6 };
+
+	memset(small, 0, sizeof(small));
+	raster_hline(&r, 1, 1, 5, 0x0F);
+	raster_hline(&r, 1, 4, 5, 0x0F);
+	raster_vline(&r, 1, 1, 4, 0x0F);
+	raster_set_pixel(&r, 6, 2, 0x0F);
+	raster_blit(&r, 7, 2, image, 2, 4, 4);
+	raster_blit(&r, 7, 2, image, 2, 3, 1); /* odd width over the same pixels */
+	raster_fill_rect(&r, 14, 3, 1, 2, 0x0A);
+	raster_fill_rect(&r, 20, 0, 4, 4, 0x0F); /* clipped out */
+
+	for (uint8_t y = 0; y < 6; y++) {
+		char row[17];
+		for (uint8_t x = 0; x < 16; x++)
+			row[x] = "0123456789ABCDEF"[raster_get_pixel(&r, x, y)];
+		row[16] = '\0';
+		if (strcmp(row, golden[y])) {
+			printf("golden row %u: %s, expected %s\n", y, row, golden[y]);
+			test_failed = 1;
+		}
+	}
+}
+
+static void bench(void)
+{
+	static uint8_t image[STRIDE * 37] __attribute__((aligned(4)));
+	const uint32_t rounds = 2000;
+	uint64_t t0, t1, t2;
+
+	/* a full symbol row band and a segment sized rectangle */
+	t0 = test_nsec();
+	for (uint32_t r = 0; r < rounds; r++)
+		raster_fill_rect(&raster, r & 7, 0, 240, 37, r);
+	t1 = test_nsec();
+	for (uint32_t r = 0; r < rounds; r++)
+		ref_fill_rect(r & 7, 0, 240, 37, r);
+	t2 = test_nsec();
+	printf("fill 240x37: %.2f us, per pixel %.2f us\n", (t1 - t0) / 1000.0 / rounds, (t2 - t1) / 1000.0 / rounds);
+
+	t0 = test_nsec();
+	for (uint32_t r = 0; r < rounds * 20; r++)
+		raster_fill_rect(&raster, 30 + (r & 7), 10, 14, 3, r);
+	t1 = test_nsec();
+	for (uint32_t r = 0; r < rounds * 20; r++)
+		ref_fill_rect(30 + (r & 7), 10, 14, 3, r);
+	t2 = test_nsec();
+	printf("fill 14x3: %.3f us, per pixel %.3f us\n", (t1 - t0) / 1000.0 / rounds / 20, (t2 - t1) / 1000.0 / rounds / 20);
+
+	t0 = test_nsec();
+	for (uint32_t r = 0; r < rounds; r++)
+		raster_blit(&raster, r & 1, 0, image, STRIDE, 240, 37);
+	t1 = test_nsec();
+	for (uint32_t r = 0; r < rounds; r++)
+		ref_blit(r & 1, 0, image, STRIDE, 240, 37);
+	t2 = test_nsec();
+	printf("blit 240x37, even and odd x: %.2f us, per pixel %.2f us\n",
+		   (t1 - t0) / 1000.0 / rounds, (t2 - t1) / 1000.0 / rounds);
+}
+
+int main(void)
+{
+	test_random();
+	test_golden();
+	bench();
+	return test_failed;
+}
@@ -0,0 +1,102 @@
+/**
+ * Scan queue with a producer and a consumer thread, as the scanner interrupt
+ * and the main loop: every line is received once and in order, or counted as
+ * skipped by scanq_peek_latest(), and its contents are never torn.
+ *
+ * MIT License
+ */
+#include <pthread.h>
+#include <sched.h>
+
+#include "test.h"
+#include "scanq.h"
+
+#define LINES 1000000
+
+static scan_queue_t queue;
+static uint32_t overruns;
+
+/* fill a line with its sequence number */
+static void *producer(void *arg)
+{
+	(void)arg;
+	for (uint32_t seq = 0; seq < LINES;) {
+		scan_t *line = scanq_reserve(&queue);
+		if (!line) {
+			overruns++; /* the scanner would scan to the spare line, here it retries */
+			sched_yield();
+			continue;
+		}
+		line->stamp = seq;
+		for (uint8_t i = 0; i < NUM_SCAN_POS; i++)
+			line->scan_buf[i] = seq + i;
+		line->changed = 1u << (seq % NUM_SCAN_POS);
+		scanq_commit(&queue);
+		seq++;
+	}
+	return NULL;
+}
+
+static bool line_is_whole(const scan_t *line)
+{
+	for (uint8_t i = 0; i < NUM_SCAN_POS; i++) {
+		if (line->scan_buf[i] != (uint8_t)(line->stamp + i))
+			return false;
+	}
+	return true;
+}
+
+/**
+ * @param latest: skip to the newest line as with APP_SCAN_COALESCE
+ */
+static void run(bool latest)
+{
+	pthread_t thread;
+	uint32_t expect = 0, received = 0, skipped_sum = 0, torn = 0, disorder = 0, lost_changes = 0;
+
+	scanq_init(&queue);
+	overruns = 0;
+	uint64_t t0 = test_nsec();
+	pthread_create(&thread, NULL, producer, NULL);
+	while (expect < LINES) {
+		uint32_t skipped = 0;
+		scan_t *line = latest ? scanq_peek_latest(&queue, &skipped) : scanq_peek(&queue);
+		if (!line) {
+			sched_yield(); /* let the producer run on a single CPU */
+			continue;
+		}
+		if (line->stamp != expect + skipped)
+			disorder++;
+		if (!line_is_whole(line))
+			torn++;
+		/* changes of skipped lines are merged to the newest one */
+		uint16_t changes = 0;
+		for (uint32_t seq = expect; seq <= line->stamp && seq - expect < NUM_SCAN_POS; seq++)
+			changes |= 1u << (seq % NUM_SCAN_POS);
+		if ((line->changed & changes) != changes)
+			lost_changes++;
+		expect = line->stamp + 1;
+		skipped_sum += skipped;
+		received++;
+		scanq_release(&queue);
+	}
+	pthread_join(thread, NULL);
+	uint64_t t1 = test_nsec();
+
+	printf("%s: %u received, %u skipped, %u producer retries, max used %u of %u, %.1f ns per line\n",
+		   latest ? "peek latest" : "peek", received, skipped_sum, overruns, queue.max_used, SCANQ_SIZE,
+		   (double)(t1 - t0) / LINES);
+	CHECK(received + skipped_sum == LINES);
+	CHECK(!disorder);
+	CHECK(!torn);
+	CHECK(!lost_changes);
+	if (!latest)
+		CHECK(!skipped_sum);
+}
+
+int main(void)
+{
+	run(false);
+	run(true);
+	return test_failed;
+}
@@ -0,0 +1,38 @@
+/**
+ * Minimal helpers for host tests of the library code.
+ *
+ * MIT License
+ */
+#ifndef MK52_TEST_H
+#define MK52_TEST_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+static int test_failed;
+
+/* report a failed condition and carry on, the test returns test_failed */
+#define CHECK(cond) do { \
+	if (!(cond)) { \
+		printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+		test_failed = 1; \
+	} \
+} while (0)
+
+static inline uint64_t test_nsec(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+/* xorshift32, repeatable pseudo-random numbers */
+static inline uint32_t test_rand(uint32_t *state) {
+	uint32_t x = *state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	return *state = x;
+}
+
+#endif
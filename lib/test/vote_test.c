@@ -0,0 +1,132 @@
+/**
+ * Majority vote of oversampled segments: bit-sliced vote against a plain
+ * per-bit count, error rates on synthetic noisy traces and timing.
+ *
+ * MIT License
+ */
+#include <string.h>
+
+#include "test.h"
+#include "vfd.h"
+
+#define TRACE_CYCLES 100000
+
+/* plain per-bit majority of one position */
+static uint8_t vote_naive(const uint8_t *samples, uint8_t n)
+{
+	uint8_t vote = 0;
+	for (uint8_t bit = 0; bit < 8; bit++) {
+		uint8_t cnt = 0;
+		for (uint8_t i = 0; i < n; i++)
+			cnt += (samples[i] >> bit) & 1;
+		if (cnt > n / 2)
+			vote |= 1 << bit;
+	}
+	return vote;
+}
+
+static void vote_cycle_naive(const uint8_t *samples, uint8_t n, uint8_t *out)
+{
+	for (uint8_t pos = 0; pos < NUM_SCAN_POS; pos++)
+		out[pos] = vote_naive(&samples[pos * n], n);
+}
+
+/* every bit of a sample is flipped with probability 1 / 'inv_p' */
+static uint8_t noisy(uint8_t seg, uint32_t inv_p, uint32_t *rnd)
+{
+	for (uint8_t bit = 0; bit < 8; bit++) {
+		if (test_rand(rnd) % inv_p == 0)
+			seg ^= 1 << bit;
+	}
+	return seg;
+}
+
+static void test_vote(void)
+{
+	uint32_t rnd = 1;
+	for (uint32_t iter = 0; iter < 100000; iter++) {
+		uint8_t n = 1 + 2 * (iter % 4);
+		uint32_t w[VFD_VOTE_MAX], corrected;
+		for (uint8_t i = 0; i < n; i++)
+			w[i] = test_rand(&rnd);
+		uint32_t vote = vfd_vote(w, n, &corrected);
+		uint32_t expect_corr = 0;
+		for (uint8_t lane = 0; lane < 32; lane++) {
+			uint8_t cnt = 0;
+			for (uint8_t i = 0; i < n; i++)
+				cnt += (w[i] >> lane) & 1;
+			uint32_t bit = (cnt > n / 2) ? 1 : 0;
+			CHECK(((vote >> lane) & 1) == bit);
+			if (cnt && cnt != n)
+				expect_corr |= 1u << lane;
+		}
+		CHECK(corrected == expect_corr);
+	}
+}
+
+/**
+ * run TRACE_CYCLES cycles of noisy samples of random segments,
+ * print the share of wrong positions before and after the vote
+ */
+static void trace(uint8_t n, uint32_t inv_p)
+{
+	uint8_t samples[NUM_SCAN_POS * VFD_VOTE_MAX];
+	uint8_t truth[NUM_SCAN_POS], out[NUM_SCAN_POS], ref[NUM_SCAN_POS];
+	uint32_t rnd = 7, raw_wrong = 0, voted_wrong = 0, bits = 0;
+
+	for (uint32_t c = 0; c < TRACE_CYCLES; c++) {
+		for (uint8_t pos = 0; pos < NUM_SCAN_POS; pos++) {
+			truth[pos] = test_rand(&rnd);
+			for (uint8_t i = 0; i < n; i++)
+				samples[pos * n + i] = noisy(truth[pos], inv_p, &rnd);
+			raw_wrong += samples[pos * n] != truth[pos];
+		}
+		bits += vfd_vote_cycle(samples, n, out);
+		vote_cycle_naive(samples, n, ref);
+		CHECK(!memcmp(out, ref, sizeof(out)));
+		for (uint8_t pos = 0; pos < NUM_SCAN_POS; pos++)
+			voted_wrong += out[pos] != truth[pos];
+	}
+	uint32_t total = TRACE_CYCLES * NUM_SCAN_POS;
+	printf("x%u, bit error 1/%-3u: wrong positions %6.3f%% single sample, %6.3f%% voted, %.2f bits corrected per cycle\n",
+		   n, inv_p, raw_wrong * 100.0 / total, voted_wrong * 100.0 / total, (double)bits / TRACE_CYCLES);
+}
+
+/* nsec per voted cycle, bit-sliced and plain count */
+static void bench(uint8_t n)
+{
+	static uint8_t samples[64][NUM_SCAN_POS * VFD_VOTE_MAX];
+	uint8_t out[NUM_SCAN_POS];
+	uint32_t rnd = 3, sum = 0;
+	const uint32_t rounds = 200000;
+
+	for (uint32_t i = 0; i < 64; i++)
+		for (uint32_t k = 0; k < sizeof(samples[0]); k++)
+			samples[i][k] = noisy(0x5B, 20, &rnd);
+
+	uint64_t t0 = test_nsec();
+	for (uint32_t r = 0; r < rounds; r++) {
+		sum += vfd_vote_cycle(samples[r & 63], n, out);
+		sum += out[r % NUM_SCAN_POS];
+	}
+	uint64_t t1 = test_nsec();
+	for (uint32_t r = 0; r < rounds; r++) {
+		vote_cycle_naive(samples[r & 63], n, out);
+		sum += out[r % NUM_SCAN_POS];
+	}
+	uint64_t t2 = test_nsec();
+	printf("x%u: bit-sliced %.1f ns per cycle, per-bit count %.1f ns per cycle (%u)\n",
+		   n, (double)(t1 - t0) / rounds, (double)(t2 - t1) / rounds, sum & 1);
+}
+
+int main(void)
+{
+	test_vote();
+	for (uint8_t n = 1; n <= VFD_VOTE_MAX; n += 2) {
+		trace(n, 100);
+		trace(n, 20);
+	}
+	for (uint8_t n = 3; n <= VFD_VOTE_MAX; n += 2)
+		bench(n);
+	return test_failed;
+}
@@ -45,6 +45,17 @@ static inline void tim_disable(TIM_TypeDef *tim) {
 	tim->CR1 &= ~TIM_CR1_CEN;
 }
 
+/** start timer with DMA request on update event instead of interrupt */
+static inline void tim_dma_enable(TIM_TypeDef *tim) {
+	tim->DIER |= TIM_DIER_UDE;
+	tim->CR1 |= TIM_CR1_CEN;
+}
+
+static inline void tim_dma_disable(TIM_TypeDef *tim) {
+	tim->DIER &= ~TIM_DIER_UDE;
+	tim->CR1 &= ~TIM_CR1_CEN;
+}
+
 /**
  * initialize ARR with the new value and update it by first
  * setting EGR:TIM_EGR_UG flag and
@@ -0,0 +1,192 @@
+/**
+ * Elektronika MK-52 VFD scan line post-processing.
+ *
+ * MIT License
+ */
+#include <string.h>
+
+#include "vfd.h"
+
+/* mapping to convert our scanning indexes to digits' indexes */
+const uint8_t digits_map[NUM_SCAN_POS] = {8, 7, 6, 5, 4, 3, 2, 1, 0, 11, 10, 9, 12, 13};
+
+void vfd_scan_store_all(vfd_scan_t *scan, const uint8_t *samples)
+{
+	for (uint8_t i = 0; i < NUM_SCAN_POS; i++)
+		vfd_scan_store(scan, digits_map[i], samples[i]);
+}
+
+uint8_t vfd_scan_finish(vfd_scan_t *scan, bool keys)
+{
+	scan_t *line = scan->line;
+
+	/* virtual positions are included, they are printed as well */
+	scan->changed |= scan->raw_new;
+	if (!keys) {
+		/* ignore virtual digits to avoid false positive events */
+		scan->raw_new &= DIGITS_MASK;
+		scan->raw_valid &= DIGITS_MASK;
+	}
+
+	/* at list one real digit had changed */
+	if (scan->raw_new && scan->raw_valid) {
+		scan->is_running = (line->key[0] == PROGRAM_RUNNING) ? LINE_TYPE_EXEC : 0;
+		/* only '-' is valid for the first position */
+		line->scan_buf[0] &= SEG_G;
+		scan->last[0] &= SEG_G;
+		line->scan_time = scan->scan_time;
+		line->changed = scan->changed;
+		line->line_type = LINE_TYPE_NORMAL | scan->is_running;
+		scan->scan_time = 0;
+		if (!vfd_scan_is_spare(scan)) /* keep changes of the lost line for the next one */
+			scan->changed = 0;
+		return line->line_type;
+	}
+
+	if (!scan->raw_valid) { /* all digits are blank */
+		uint16_t scan_time = scan->scan_time;
+		scan->scan_time += 1;
+		if (!scan_time) { /* first invalid scan */
+			line->changed = 0;
+			line->line_type = LINE_TYPE_IDLE | scan->is_running;
+			return line->line_type;
+		}
+	}
+	return 0;
+}
+
+void vfd_pll_init(vfd_pll_t *pll, uint32_t min_period)
+{
+	memset(pll, 0, sizeof(vfd_pll_t));
+	pll->min_period = min_period;
+	vfd_pll_reset_stats(pll);
+}
+
+void vfd_pll_reset_stats(vfd_pll_t *pll)
+{
+	pll->err_min = INT32_MAX;
+	pll->err_max = INT32_MIN;
+	pll->err_abs = pll->err_num = 0;
+}
+
+bool vfd_pll_start(vfd_pll_t *pll, uint32_t ts)
+{
+	uint32_t meas = ts - pll->start;
+	bool started = pll->start != 0;
+	pll->start = ts;
+
+	if (!started || meas < pll->min_period || meas >= (UINT32_MAX >> VFD_PLL_FRAC)) {
+		/* the first edge or MK52 is starting up */
+		pll->locked = false;
+		return false;
+	}
+
+	uint32_t period = pll->period >> VFD_PLL_FRAC;
+	uint32_t diff = (meas > period) ? meas - period : period - meas;
+	if (!pll->locked || diff > (period >> 3)) {
+		/* too far from the filtered value: MK52 was stopped or restarted */
+		pll->period = meas << VFD_PLL_FRAC;
+		pll->locked = true;
+	} else
+		pll->period += ((int32_t)((meas << VFD_PLL_FRAC) - pll->period)) >> VFD_PLL_GAIN;
+	pll->window = pll->period / NUM_SCAN_POS;
+	return true;
+}
+
+int32_t vfd_pll_error(vfd_pll_t *pll, uint32_t target, uint32_t ts)
+{
+	int32_t err = ts - target;
+
+	if (err < pll->err_min)
+		pll->err_min = err;
+	if (err > pll->err_max)
+		pll->err_max = err;
+	pll->err_abs += (err < 0) ? -err : err;
+	pll->err_num++;
+	return err;
+}
+
+void vfd_pll_sample(vfd_pll_t *pll, uint32_t target, uint32_t ts)
+{
+	vfd_pll_learn(pll, vfd_pll_error(pll, target, ts));
+}
+
+void vfd_pll_learn(vfd_pll_t *pll, int32_t err)
+{
+	/* integral loop: learn the latency so the next samples are centered */
+	pll->latency += (err * (1 << VFD_PLL_FRAC)) >> VFD_PLL_GAIN;
+	/* latency can not be negative or longer than a half of the window */
+	if (pll->latency < 0)
+		pll->latency = 0;
+	if (pll->latency > (int32_t)(pll->window >> 1))
+		pll->latency = pll->window >> 1;
+}
+
+uint32_t vfd_pll_step(const vfd_pll_t *pll, uint8_t num, uint32_t *first)
+{
+	uint32_t exact = pll->window / num; /* Q.8 */
+	uint32_t step = (exact + (1 << (VFD_PLL_FRAC - 1))) >> VFD_PLL_FRAC;
+	/* rounding error of one step and half of it over all steps of the cycle, Q.8 */
+	int32_t diff = (int32_t)((step << VFD_PLL_FRAC) - exact);
+	int32_t shift = diff * (NUM_SCAN_POS * num - 1) / 2;
+
+	*first = vfd_pll_target(pll, 0, 0, num) - ((shift + (1 << (VFD_PLL_FRAC - 1))) >> VFD_PLL_FRAC);
+	return step;
+}
+
+uint32_t vfd_vote(const uint32_t *w, uint8_t n, uint32_t *corrected)
+{
+	uint32_t cnt[3] = {0, 0, 0}; /* bit-sliced per lane counter, up to 7 */
+	uint32_t carry, tmp;
+	uint8_t i, k;
+
+	for (i = 0; i < n; i++) {
+		carry = w[i];
+		for (k = 0; k < 3 && carry; k++) {
+			tmp = cnt[k] & carry;
+			cnt[k] ^= carry;
+			carry = tmp;
+		}
+	}
+
+	/* bit-sliced compare of counters with the majority threshold */
+	uint8_t thr = (n + 1) / 2;
+	uint32_t gt = 0, eq = ~0u;
+	for (k = 3; k-- > 0;) {
+		if (thr & (1 << k))
+			eq &= cnt[k];
+		else {
+			gt |= eq & cnt[k];
+			eq &= ~cnt[k];
+		}
+	}
+	uint32_t vote = gt | eq;
+
+	tmp = 0;
+	for (i = 0; i < n; i++)
+		tmp |= w[i] ^ vote;
+	*corrected = tmp;
+	return vote;
+}
+
+uint16_t vfd_vote_cycle(const uint8_t *samples, uint8_t n, uint8_t *out)
+{
+	uint32_t w[VFD_VOTE_MAX];
+	uint32_t mask;
+	uint16_t corrected = 0;
+
+	/* four positions per word, so one vote covers 32 segments */
+	for (uint8_t pos = 0; pos < NUM_SCAN_POS; pos += 4) {
+		uint8_t num = (NUM_SCAN_POS - pos) < 4 ? (NUM_SCAN_POS - pos) : 4;
+		for (uint8_t i = 0; i < n; i++) {
+			w[i] = 0;
+			for (uint8_t b = 0; b < num; b++)
+				w[i] |= (uint32_t)samples[(pos + b) * n + i] << (b * 8);
+		}
+		uint32_t vote = vfd_vote(w, n, &mask);
+		corrected += __builtin_popcount(mask);
+		for (uint8_t b = 0; b < num; b++)
+			out[pos + b] = vote >> (b * 8);
+	}
+	return corrected;
+}
@@ -0,0 +1,230 @@
+/**
+ * Elektronika MK-52 VFD scan line post-processing.
+ *
+ * Does not depend on HAL or any STM32 peripherals, so it can be built
+ * for a host to check scanner logic without the board.
+ *
+ * MIT License
+ */
+#ifndef MK52_VFD_SCAN_H
+#define MK52_VFD_SCAN_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SEG_A   0x01
+#define SEG_B   0x02
+#define SEG_C   0x04
+#define SEG_D   0x08
+#define SEG_E   0x10
+#define SEG_F   0x20
+#define SEG_G   0x40
+#define SEG_DOT 0x80
+
+#define NUM_DIGITS 12 /* 12 real digit positions */
+#define NUM_VIRT   2  /* 2 virtual digit positions */
+#define NUM_SCAN_POS (NUM_DIGITS + NUM_VIRT) /* 12 real digit positions and 2 virtual */
+#define PROGRAM_RUNNING 0x6F /* '9' at virtual position 0 as a running program flag */
+
+#define DIGITS_MASK ((1u << NUM_DIGITS) - 1) /* mask of real digit positions */
+
+#define VFD_VOTE_MAX 7 /* max number of samples per digit for majority vote */
+
+#define LINE_TYPE_NORMAL 0x80
+#define LINE_TYPE_IDLE   0x40
+#define LINE_TYPE_EXEC   0x20
+
+typedef struct scan_s {
+	union {
+		uint8_t scan_buf[NUM_SCAN_POS]; /** one line of scanned segments codes */
+		struct {
+			uint8_t digits[NUM_DIGITS]; /** digit scans */
+			uint8_t key[NUM_VIRT];      /** key scans */
+		};
+	};
+	uint32_t stamp;     /** sys clocks timestamp of posting the line, set by the scanner */
+	uint16_t scan_time; /** number of scan intervals before detecting this line */
+	uint16_t changed;   /** mask of positions changed since the previous normal line */
+	uint8_t  line_type; /** LINE_TYPE_* of this line */
+} scan_t;
+
+/** state of the scan cycle in progress */
+typedef struct vfd_scan_s {
+	uint8_t  last[NUM_SCAN_POS]; /** segments codes of the previous scan cycle */
+	scan_t  *line;       /** line to scan to, reserved slot of the scan queue or 'spare' */
+	scan_t   spare;      /** line to scan to if there is no free slot */
+	uint16_t scan_time;  /** number of blank scan cycles */
+	uint16_t changed;    /** mask of values changed since the last posted normal line */
+	uint16_t raw_new;    /** mask of values changed from the last scan */
+	uint16_t raw_valid;  /** mask of digits with at least one segment on */
+	uint8_t  is_running; /** LINE_TYPE_EXEC if program execution in progress */
+} vfd_scan_t;
+
+/* mapping to convert our scanning indexes to digits' indexes */
+extern const uint8_t digits_map[NUM_SCAN_POS];
+
+/**
+ * reset change masks at the beginning of a scan cycle
+ * @param line: line to scan to, NULL to scan to the spare one
+ */
+static inline void vfd_scan_start(vfd_scan_t *scan, scan_t *line) {
+	scan->line = line ? line : &scan->spare;
+	scan->raw_new = scan->raw_valid = 0;
+}
+
+/* true if the cycle is scanned to the spare line and the result will be lost */
+static inline bool vfd_scan_is_spare(vfd_scan_t *scan) {
+	return scan->line == &scan->spare;
+}
+
+/**
+ * store segments of one digit position
+ * @param idx: digit index (not the scanning index)
+ * @param seg: segments codes
+ */
+static inline void vfd_scan_store(vfd_scan_t *scan, uint8_t idx, uint8_t seg) {
+	if (seg)
+		scan->raw_valid |= 1 << idx;
+	if (scan->last[idx] != seg)
+		scan->raw_new |= 1 << idx;
+	scan->last[idx] = seg;
+	scan->line->scan_buf[idx] = seg;
+}
+
+/**
+ * store the whole cycle of segments captured in the scanning order,
+ * as copied by DMA from the segments port
+ * @param samples: NUM_SCAN_POS segments codes
+ */
+void vfd_scan_store_all(vfd_scan_t *scan, const uint8_t *samples);
+
+/**
+ * complete the scan cycle, set line type, scan time and changes mask of the scanned line,
+ * changes of all positions are accumulated until a normal line is posted to the queue
+ * @param keys: true to detect changes in the virtual (keyboard) positions as well
+ *
+ * @return LINE_TYPE_* event to post to the main loop, 0 if nothing to post
+ */
+uint8_t vfd_scan_finish(vfd_scan_t *scan, bool keys);
+
+/**
+ * phase-locked scan scheduler:
+ * keeps filtered scan cycle period with fractional part and calculates
+ * sampling points in the middle of every grid window, all in sys clocks,
+ * the same units as DWT->CYCCNT and TIM4 running without prescaler
+ */
+#define VFD_PLL_FRAC 8 /* fractional bits of period, window and latency */
+#define VFD_PLL_GAIN 3 /* loop filter gain: 1/8 of the error per sample */
+
+typedef struct vfd_pll_s {
+	uint32_t min_period; /** shortest valid scan cycle, sys clocks */
+	uint32_t start;      /** timestamp of the current cycle start (grid 8 rising edge) */
+	uint32_t period;     /** filtered scan cycle period, sys clocks Q.8 */
+	uint32_t window;     /** grid window length, sys clocks Q.8 */
+	int32_t  latency;    /** learned delay from a scheduled point to the sample, sys clocks Q.8 */
+	/* phase error statistics, sys clocks */
+	int32_t  err_min;
+	int32_t  err_max;
+	uint32_t err_abs;    /** sum of absolute errors */
+	uint32_t err_num;    /** number of errors in the sum */
+	bool     locked;     /** true if period is known */
+} vfd_pll_t;
+
+/** @param min_period: shortest valid scan cycle in sys clocks */
+void vfd_pll_init(vfd_pll_t *pll, uint32_t min_period);
+
+void vfd_pll_reset_stats(vfd_pll_t *pll);
+
+/**
+ * start a new scan cycle
+ * @param ts: timestamp of the grid 8 rising edge
+ *
+ * @return true if locked and scanning can be started
+ */
+bool vfd_pll_start(vfd_pll_t *pll, uint32_t ts);
+
+/**
+ * sampling point of a position in the scanning order
+ * @param idx: scanning index, 0 to NUM_SCAN_POS - 1
+ * @param sub: sample in the window, 0 to num - 1
+ * @param num: number of samples in the window, evenly spread
+ *
+ * @return timestamp of the sampling point
+ */
+static inline uint32_t vfd_pll_target(const vfd_pll_t *pll, uint8_t idx, uint8_t sub, uint8_t num) {
+	uint32_t offset = pll->window * idx + (pll->window * (2 * sub + 1)) / (2 * num);
+	return pll->start + (offset >> VFD_PLL_FRAC);
+}
+
+/**
+ * delay from 'now' to schedule a sampling point, compensated by learned latency
+ * @return delay in sys clocks, 0 if the point had been already missed
+ */
+static inline uint32_t vfd_pll_delay(const vfd_pll_t *pll, uint32_t target, uint32_t now) {
+	int32_t delay = (int32_t)(target - now) - (pll->latency >> VFD_PLL_FRAC);
+	return (delay > 0) ? delay : 0;
+}
+
+/**
+ * account phase error in statistics only
+ * @param target: scheduled sampling point
+ * @param ts: timestamp of the sample
+ *
+ * @return phase error, sys clocks
+ */
+int32_t vfd_pll_error(vfd_pll_t *pll, uint32_t target, uint32_t ts);
+
+/**
+ * adjust latency for the next sampling points
+ * @param err: delay of a sample from its scheduled point, sys clocks
+ */
+void vfd_pll_learn(vfd_pll_t *pll, int32_t err);
+
+/**
+ * account the actual sampling time and adjust latency for the next sampling points
+ * @param target: scheduled sampling point
+ * @param ts: timestamp of the sample
+ */
+void vfd_pll_sample(vfd_pll_t *pll, uint32_t target, uint32_t ts);
+
+/**
+ * fixed timer step for 'num' evenly spread samples per window over the whole cycle,
+ * as a timer reloaded by hardware can not follow the fractional window:
+ * the step is rounded to whole clocks and the first sample is moved by half of
+ * the rounding error of the cycle, so the error is centered and within
+ * (samples per cycle - 1) / 4 clocks instead of growing to a clock per sample
+ * @param first: timestamp of the first sample
+ *
+ * @return step in sys clocks
+ */
+uint32_t vfd_pll_step(const vfd_pll_t *pll, uint8_t num, uint32_t *first);
+
+/**
+ * per-bit majority vote of 'n' sample words, bit-sliced:
+ * every bit of a word is an independent voting lane
+ * @param w: 'n' sample words
+ * @param n: odd number of samples, 1 to VFD_VOTE_MAX
+ * @param corrected: mask of lanes where at least one sample disagreed with the result
+ *
+ * @return voted word
+ */
+uint32_t vfd_vote(const uint32_t *w, uint8_t n, uint32_t *corrected);
+
+/**
+ * vote one cycle of oversampled segments
+ * @param samples: NUM_SCAN_POS * n segments codes, 'n' consecutive samples per position
+ * @param n: odd number of samples per position, 1 to VFD_VOTE_MAX
+ * @param out: NUM_SCAN_POS voted segments codes
+ *
+ * @return number of segment bits corrected by the vote
+ */
+uint16_t vfd_vote_cycle(const uint8_t *samples, uint8_t n, uint8_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,206 @@
+#!/usr/bin/env python3
+"""
+Decoder of MK-52 VFD scanner binary telemetry, enabled by "print binary on".
+
+Reads COBS frames, see lib/telemetry.h, from a serial port, a file or stdin,
+and prints scan lines in the same text format as "print scan on" does.
+Text between frames, such as CLI replies, is printed as it is.
+Received, dropped and broken records and the sustained frame rate are
+reported to stderr.
+
+    mk52tlm.py /dev/ttyUSB0 --baud 38400
+    mk52tlm.py capture.bin
+
+MIT License
+"""
+import argparse
+import os
+import struct
+import sys
+import time
+
+NUM_DIGITS = 12
+NUM_SCAN_POS = 14
+
+LINE_TYPE_NORMAL = 0x80
+LINE_TYPE_IDLE = 0x40
+LINE_TYPE_EXEC = 0x20
+
+TLM_SKIPPED = 0x01
+TLM_BLANK = 0x02
+TLM_HEX = 0x04
+
+SEG_DOT = 0x80
+
+# printable symbols of scan codes, as seg_map and seg_sym in core/src/main.c
+SEG_SYM = {
+    0x00: ' ', 0x40: '-', 0x3F: '0', 0x06: '1', 0x5B: '2', 0x4F: '3',
+    0x66: '4', 0x6D: '5', 0x7D: '6', 0x07: '7', 0x7F: '8', 0x6F: '9',
+    0x39: 'C', 0x79: 'E', 0x38: 'L', 0x31: 'R', 0x46: '{', 0x47: 'F',
+    0x67: 'P',
+}
+
+
+def crc16(data):
+    """CRC-16/CCITT-FALSE"""
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
+    return crc
+
+
+def cobs_decode(data):
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data):
+            return None
+        out += data[i + 1:i + code]
+        i += code
+        if code < 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def scan_to_text(scan):
+    sym = SEG_SYM.get(scan & 0x7F)
+    if sym is None:
+        return '(%02X)' % scan
+    return sym + ('.' if scan & SEG_DOT else '')
+
+
+class Decoder:
+    def __init__(self, out):
+        self.out = out
+        self.scan = [0] * NUM_SCAN_POS
+        self.seq = None
+        self.blank = False
+        self.records = 0
+        self.dropped = 0
+        self.broken = 0
+        self.first_stamp = None
+        self.last_stamp = None
+
+    def record(self, rec):
+        if len(rec) < 10 or crc16(rec[:-2]) != struct.unpack_from('<H', rec, len(rec) - 2)[0]:
+            return False
+        seq, rtype, stamp, mask = struct.unpack_from('<BBIH', rec, 0)
+        pos = 8
+        for i in range(NUM_SCAN_POS):
+            if mask & (1 << i):
+                self.scan[i] = rec[pos]
+                pos += 1
+        skipped = 0
+        if rtype & TLM_SKIPPED:
+            skipped, = struct.unpack_from('<I', rec, pos)
+            pos += 4
+        if rtype & TLM_BLANK:
+            cycles, blank = struct.unpack_from('<HI', rec, pos)
+            pos += 6
+
+        if self.seq is not None:
+            self.dropped += (seq - self.seq - 1) & 0xFF
+        self.seq = seq
+        self.records += 1
+        if self.first_stamp is None:
+            self.first_stamp = stamp
+        self.last_stamp = stamp
+
+        if rtype & LINE_TYPE_NORMAL:
+            text = ''
+            if rtype & TLM_BLANK:
+                if not self.blank:  # the blank record was dropped
+                    text += "'             '"
+                text += ' %u cycles (%u,%u ms)\r\n' % (cycles, blank // 1000, blank % 1000)
+            if rtype & TLM_HEX:
+                text += ''.join('%02X ' % s for s in self.scan)
+            text += "'" + ''.join(scan_to_text(s) for s in self.scan[:NUM_DIGITS])
+            text += "' [" + ''.join(scan_to_text(s) for s in self.scan[NUM_DIGITS:]) + ']'
+            if rtype & LINE_TYPE_EXEC:
+                text += ' RUNNIG'
+            if skipped:
+                text += ' (%u skipped)' % skipped
+            self.out.write(text + '\n')
+            self.blank = False
+        elif rtype & LINE_TYPE_IDLE:
+            self.out.write("'             '")
+            self.blank = True
+        return True
+
+    def chunk(self, data):
+        """bytes between zero bytes: a frame or text"""
+        if not data:
+            return
+        rec = cobs_decode(data)
+        if rec is not None and self.record(rec):
+            return
+        if all(0x20 <= b < 0x7F or b in (0x0A, 0x0D, 0x09) for b in data):
+            self.out.write(data.decode('ascii'))
+        else:
+            self.broken += 1
+
+    def fps(self):
+        """records per second by device timestamps"""
+        if self.first_stamp is None or self.last_stamp == self.first_stamp:
+            return 0.0
+        return (self.records - 1) * 1000.0 / ((self.last_stamp - self.first_stamp) & 0xFFFFFFFF)
+
+    def report(self, elapsed):
+        sys.stderr.write('%u records, %u dropped, %u broken, %.1f frames/s sustained, %.1f/s received\n' %
+                         (self.records, self.dropped, self.broken, self.fps(),
+                          self.records / elapsed if elapsed > 0 else 0.0))
+
+
+def open_input(path, baud):
+    if path == '-':
+        return sys.stdin.buffer.raw
+    fd = os.open(path, os.O_RDONLY | os.O_NOCTTY)
+    if os.isatty(fd):
+        import termios
+        import tty
+        tty.setraw(fd)
+        attr = termios.tcgetattr(fd)
+        speed = getattr(termios, 'B%u' % baud)
+        attr[4] = attr[5] = speed
+        termios.tcsetattr(fd, termios.TCSANOW, attr)
+    return os.fdopen(fd, 'rb', buffering=0)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='MK-52 VFD scanner binary telemetry decoder')
+    parser.add_argument('input', nargs='?', default='-', help='serial port, file or - for stdin')
+    parser.add_argument('--baud', type=int, default=38400, help='serial port baud rate')
+    parser.add_argument('--stats', type=float, default=10.0, help='seconds between reports, 0 for the end only')
+    args = parser.parse_args()
+
+    src = open_input(args.input, args.baud)
+    dec = Decoder(sys.stdout)
+    buf = bytearray()
+    start = last = time.monotonic()
+    try:
+        while True:
+            data = src.read(4096)
+            if not data:
+                break
+            buf += data
+            *chunks, rest = bytes(buf).split(b'\0')
+            buf = bytearray(rest)
+            for chunk in chunks:
+                dec.chunk(chunk)
+            sys.stdout.flush()
+            now = time.monotonic()
+            if args.stats and now - last >= args.stats:
+                dec.report(now - start)
+                last = now
+    except KeyboardInterrupt:
+        pass
+    dec.chunk(bytes(buf))
+    dec.report(time.monotonic() - start)
+
+
+if __name__ == '__main__':
+    main()